@@ -17,6 +17,7 @@
 #include "filehdr.h"
 #include "openfile.h"
 #include "synchdisk.h"
+#include "pool.h"
 
 //----------------------------------------------------------------------
 // OpenFile::OpenFile
@@ -126,14 +127,14 @@ int OpenFile::ReadAt(char *into, int numBytes, int position)
     numSectors = 1 + lastSector - firstSector;
 
     // read in all the full and partial sectors that we need
-    buf = new char[numSectors * SectorSize];
+    buf = (char *)PoolAlloc(numSectors * SectorSize);
     for (i = firstSector; i <= lastSector; i++)
         kernel->synchDisk->ReadSector(hdr->ByteToSector(i * SectorSize),
                                       &buf[(i - firstSector) * SectorSize]);
 
     // copy the part we want
     bcopy(&buf[position - (firstSector * SectorSize)], into, numBytes);
-    delete[] buf;
+    PoolFree(buf, numSectors * SectorSize);
     return numBytes;
 }
 
@@ -154,7 +155,7 @@ int OpenFile::WriteAt(char *from, int numBytes, int position)
     lastSector = divRoundDown(position + numBytes - 1, SectorSize);
     numSectors = 1 + lastSector - firstSector;
 
-    buf = new char[numSectors * SectorSize];
+    buf = (char *)PoolAlloc(numSectors * SectorSize);
 
     firstAligned = (position == (firstSector * SectorSize));
     lastAligned = ((position + numBytes) == ((lastSector + 1) * SectorSize));
@@ -173,7 +174,7 @@ int OpenFile::WriteAt(char *from, int numBytes, int position)
     for (i = firstSector; i <= lastSector; i++)
         kernel->synchDisk->WriteSector(hdr->ByteToSector(i * SectorSize),
                                        &buf[(i - firstSector) * SectorSize]);
-    delete[] buf;
+    PoolFree(buf, numSectors * SectorSize);
     return numBytes;
 }
 
@@ -16,6 +16,7 @@
 
 #include "copyright.h"
 #include "synchdisk.h"
+#include "main.h"
 
 
 //----------------------------------------------------------------------
@@ -59,7 +60,9 @@ SynchDisk::ReadSector(int sectorNumber, char* data)
 {
     lock->Acquire();			// only one disk I/O at a time
     disk->ReadRequest(sectorNumber, data);
+    kernel->currentThread->waitingForIO = TRUE;
     semaphore->P();			// wait for interrupt
+    kernel->currentThread->waitingForIO = FALSE;
     lock->Release();
 }
 
@@ -77,7 +80,9 @@ SynchDisk::WriteSector(int sectorNumber, char* data)
 {
     lock->Acquire();			// only one disk I/O at a time
     disk->WriteRequest(sectorNumber, data);
+    kernel->currentThread->waitingForIO = TRUE;
     semaphore->P();			// wait for interrupt
+    kernel->currentThread->waitingForIO = FALSE;
     lock->Release();
 }
 
@@ -0,0 +1,321 @@
+// heap.cc
+//     	Routines to manage a priority queue, kept as a binary heap
+//	(see heap.h).  Heaps are implemented as templates, like lists.
+//
+//	The heap is an array in which each element is no larger than
+//	its two children, at 2i+1 and 2i+2, so the smallest is always
+//	at the top.  An item is put in at the bottom and moved up, and
+//	the top is taken out by moving the last element there and then
+//	down, each in at most log n steps.
+//
+//     	NOTE: Mutual exclusion must be provided by the caller.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+
+const int HeapInitialSize = 16;	// elements allocated to start with
+
+//----------------------------------------------------------------------
+// Heap<T>::Heap
+//	Initialize a heap, empty to start with.
+//
+//	"comp" is the function for ordering the items
+//	"moved" is the function to tell an item its index, or NULL
+//----------------------------------------------------------------------
+
+template <class T>
+Heap<T>::Heap(int (*comp)(T x, T y), void (*moved)(T x, int i))
+{
+    compare = comp;
+    this->moved = moved;
+    size = HeapInitialSize;
+    elements = new HeapElement<T>[size];
+    numInHeap = 0;
+    nextSeq = 0;
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::~Heap
+//	Prepare a heap for deallocation.  This does *NOT* free the
+//	items still in the heap.
+//----------------------------------------------------------------------
+
+template <class T>
+Heap<T>::~Heap()
+{
+    delete [] elements;
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::Less
+//	Return TRUE if elements[i] should come out of the heap before
+//	elements[j]: it is smaller, or it is equal and went in first.
+//	The sequence numbers are compared so as to allow for them
+//	wrapping around.
+//----------------------------------------------------------------------
+
+template <class T>
+bool
+Heap<T>::Less(int i, int j) const
+{
+    int result = compare(elements[i].item, elements[j].item);
+
+    if (result != 0)
+	return result < 0;
+    return (int) (elements[i].seq - elements[j].seq) < 0;
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::Swap
+//	Exchange elements[i] and elements[j].
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::Swap(int i, int j)
+{
+    HeapElement<T> temp = elements[i];
+
+    elements[i] = elements[j];
+    elements[j] = temp;
+    Moved(i);
+    Moved(j);
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::SiftUp
+//	Move elements[i] up towards the top, until it is no smaller
+//	than its parent.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::SiftUp(int i)
+{
+    while (i > 0 && Less(i, (i - 1) / 2)) {
+	Swap(i, (i - 1) / 2);
+	i = (i - 1) / 2;
+    }
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::SiftDown
+//	Move elements[i] down towards the bottom, until it is no larger
+//	than either of its children.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::SiftDown(int i)
+{
+    int child;
+
+    while ((child = 2 * i + 1) < numInHeap) {
+	if (child + 1 < numInHeap && Less(child + 1, child))
+	    child++;			// the smaller child
+	if (!Less(child, i))
+	    break;
+	Swap(i, child);
+	i = child;
+    }
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::Insert
+//      Put an "item" into the heap.  If the array is full, it is
+//	doubled in size first.
+//
+//	"item" is the thing to put into the heap.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::Insert(T item)
+{
+    if (numInHeap == size) {
+	HeapElement<T> *old = elements;
+
+	elements = new HeapElement<T>[size * 2];
+	for (int i = 0; i < size; i++)
+	    elements[i] = old[i];
+	size *= 2;
+	delete [] old;
+    }
+    elements[numInHeap].item = item;
+    elements[numInHeap].seq = nextSeq++;
+    numInHeap++;
+    Moved(numInHeap - 1);
+    SiftUp(numInHeap - 1);
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::RemoveAt
+//      Take elements[i] out of the heap, by moving the last element
+//	into its place and then up or down to where it belongs.  This
+//	takes O(log n) steps.
+//
+//	"i" is the index of the item, as last passed to "moved"
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::RemoveAt(int i)
+{
+    ASSERT(i >= 0 && i < numInHeap);
+    if (moved != NULL)
+	(*moved)(elements[i].item, -1);
+    numInHeap--;
+    if (i == numInHeap)
+	return;
+    elements[i] = elements[numInHeap];
+    Moved(i);
+    if (i > 0 && Less(i, (i - 1) / 2))
+	SiftUp(i);
+    else
+	SiftDown(i);
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::RemoveFront
+//      Take the smallest item out of the heap, and return it.
+//	The heap must not be empty.
+//----------------------------------------------------------------------
+
+template <class T>
+T
+Heap<T>::RemoveFront()
+{
+    T item = Front();
+
+    RemoveAt(0);
+    return item;
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::Find
+//      Return the index of an item in the heap, or -1 if it isn't
+//	there.  This has to look at each element in turn.
+//----------------------------------------------------------------------
+
+template <class T>
+int
+Heap<T>::Find(T item) const
+{
+    for (int i = 0; i < numInHeap; i++)
+	if (elements[i].item == item)
+	    return i;
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::Remove
+//      Take a specific item out of the heap, wherever it is.  Finding
+//	it takes O(n) steps, but removing it only O(log n); use RemoveAt
+//	instead if the heap tells the items their indexes.
+//
+//	Returns FALSE if the item wasn't in the heap.
+//
+//	"item" is the thing to take out.
+//----------------------------------------------------------------------
+
+template <class T>
+bool
+Heap<T>::Remove(T item)
+{
+    int i = Find(item);
+
+    if (i < 0)
+	return FALSE;
+    RemoveAt(i);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::Apply
+//      Apply function to every item in the heap, in the order they
+//	would come out.  This works on a copy (which doesn't tell the
+//	items their indexes), so it takes O(n log n) steps; it is meant
+//	for debugging.
+//
+//	"func" is the procedure to apply.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::Apply(void (*func)(T)) const
+{
+    Heap<T> copy(compare);
+
+    delete [] copy.elements;
+    copy.elements = new HeapElement<T>[size];
+    copy.size = size;
+    for (int i = 0; i < numInHeap; i++)
+	copy.elements[i] = elements[i];
+    copy.numInHeap = numInHeap;
+    while (!copy.IsEmpty())
+	(*func)(copy.RemoveFront());
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::SanityCheck
+//      Test whether this is still a legal heap.
+//
+//	Test: is every element no smaller than its parent?
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::SanityCheck() const
+{
+    ASSERT(numInHeap >= 0 && numInHeap <= size);
+    for (int i = 1; i < numInHeap; i++)
+	ASSERT(!Less(i, (i - 1) / 2));
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::SelfTest
+//      Test whether this module is working.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::SelfTest(T *p, int numEntries)
+{
+    int i, j;
+    T *q = new T[numEntries];
+
+    SanityCheck();
+    ASSERT(IsEmpty());
+
+    // put everything in, enough times over to force the array to grow
+    for (j = 0; j <= HeapInitialSize / numEntries; j++)
+	for (i = 0; i < numEntries; i++) {
+	    Insert(p[i]);
+	    ASSERT(IsInHeap(p[i]));
+	}
+    ASSERT(NumInHeap() == numEntries * j);
+    SanityCheck();
+
+    // take one copy of each out from the middle
+    for (i = 0; i < numEntries; i++)
+	ASSERT(Remove(p[i]));
+    SanityCheck();
+
+    // and the rest from the top, in order
+    while (NumInHeap() > numEntries) {
+	T item = RemoveFront();
+	ASSERT(compare(item, Front()) <= 0);
+    }
+    for (i = 0; i < numEntries; i++)
+	q[i] = RemoveFront();
+    ASSERT(IsEmpty());
+    for (i = 0; i < (numEntries - 1); i++)
+	ASSERT(compare(q[i], q[i + 1]) <= 0);
+    ASSERT(!Remove(p[0]));
+    SanityCheck();
+
+    delete [] q;
+}
@@ -0,0 +1,121 @@
+// heap.h
+//	Data structures to manage a priority queue, kept as a binary heap.
+//
+//	Like a SortedList, a heap always gives back its smallest item
+//	first, but it takes O(log n) steps to put an item in or take it
+//	out, rather than walking a list.  Items that compare equal come
+//	out in the order they went in, just as from a SortedList.
+//
+//	The items are kept in an array that grows as needed and is never
+//	shrunk, so once a heap has reached its working size, nothing is
+//	allocated to put an item in.
+//
+//	An item can also be taken out from the middle of the heap.
+//	Finding it takes O(n) steps, unless the heap is given a function
+//	to tell each item where in the array it is whenever it moves;
+//	then it can be taken out by that index in O(log n) steps.
+//
+//	As with lists, the heap has been tested only for primitive types
+//	(ints, pointers), and allocation and deallocation of the items
+//	themselves are to be done by the caller.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef HEAP_H
+#define HEAP_H
+
+#include "copyright.h"
+#include "debug.h"
+
+// The following class defines one slot of a heap.  The sequence number
+// records when the item was put in, to break ties.
+//
+// This class is private to this module. Made public for notational
+// convenience.
+
+template <class T>
+class HeapElement {
+  public:
+    T item;			// item in the heap
+    unsigned int seq;		// when it was inserted
+};
+
+// The following class defines a "heap", arranged so that "RemoveFront"
+// always returns the smallest item.  As for a SortedList, all types
+// to be put into a heap must have a "Compare" function defined:
+//	   int Compare(T x, T y)
+//		returns -1 if x < y
+//		returns 0 if x == y
+//		returns 1 if x > y
+// and "Remove" needs the "==" operator.  The optional "moved"
+// function, if given, is called as
+//	   void Moved(T x, int i)
+// whenever item x is put at index i of the heap, and with i == -1
+// when it is taken out; the index can then be passed to "RemoveAt".
+
+template <class T>
+class Heap {
+  public:
+    Heap(int (*comp)(T x, T y), void (*moved)(T x, int i) = NULL);
+				// initialize an empty heap
+    ~Heap();			// de-allocate the heap
+
+    void Insert(T item);	// put an item into the heap
+
+    T Front() { ASSERT(numInHeap > 0); return elements[0].item; }
+    				// Return the smallest item,
+				// without removing it
+    T RemoveFront();		// Take the smallest item out of the heap
+    bool Remove(T item);	// Take a specific item out of the heap;
+				// FALSE if it wasn't there
+    void RemoveAt(int i);	// Take out the item at index i, as
+				// last passed to "moved"
+
+    bool IsInHeap(T item) const { return Find(item) >= 0; }
+				// is the item in the heap?
+
+    int NumInHeap() { return numInHeap; }
+    				// how many items in the heap?
+    bool IsEmpty() { return numInHeap == 0; }
+    				// is the heap empty?
+    T Item(int i) { ASSERT(i >= 0 && i < numInHeap);
+		    return elements[i].item; }
+				// the i'th item, 0 <= i < NumInHeap(),
+				// in no particular order
+
+    void Apply(void (*f)(T)) const;
+    				// apply function to all items in the
+				// heap, smallest first
+
+    void SanityCheck() const;	// has this heap been corrupted?
+    void SelfTest(T *p, int numEntries);
+				// verify module is working
+
+  private:
+    HeapElement<T> *elements;	// the heap: elements[i] is no larger
+				// than elements[2i+1] or elements[2i+2]
+    int numInHeap;		// number of items in the heap
+    int size;			// number of elements allocated
+    unsigned int nextSeq;	// sequence number for the next Insert
+    int (*compare)(T x, T y);	// function for ordering the items
+    void (*moved)(T x, int i);	// function to tell an item its index,
+				// or NULL
+
+    bool Less(int i, int j) const;
+				// does elements[i] come out before
+				// elements[j]?
+    void Swap(int i, int j);	// exchange two elements
+    void Moved(int i) { if (moved != NULL)
+			    (*moved)(elements[i].item, i); }
+				// tell elements[i] where it now is
+    void SiftUp(int i);		// restore the heap after elements[i]
+    void SiftDown(int i);	// got smaller, or larger
+    int Find(T item) const;	// index of an item, or -1
+};
+
+#include "heap.cc"		// templates are really like macros
+				// so needs to be included in every
+				// file that uses the template
+#endif // HEAP_H
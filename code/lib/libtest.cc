@@ -1,6 +1,7 @@
 // libtest.cc 
 //	Driver code to call self-test routines for standard library
-//	classes -- bitmaps, lists, sorted lists, and hash tables.
+//	classes -- bitmaps, lists, sorted lists, heaps, hash tables, and
+//	pools.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -10,13 +11,15 @@
 #include "libtest.h"
 #include "bitmap.h"
 #include "list.h"
+#include "heap.h"
 #include "hash.h"
+#include "pool.h"
 #include "sysdep.h"
 
 //----------------------------------------------------------------------
 // IntCompare
 //	Compare two integers together.  Serves as the comparison
-//	function for testing SortedLists
+//	function for testing SortedLists and Heaps
 //----------------------------------------------------------------------
 
 static int 
@@ -50,9 +53,47 @@ HashKey(char *str) {
     return atoi(str);
 }
 
-// Array of values to be inserted into a List or SortedList. 
+// Array of values to be inserted into a List, SortedList or Heap.
 static int listTestVector[] = { 9, 5, 7 };
 
+// Where each of those values is in an indexed Heap (the values are < 10).
+static int heapIndex[10];
+
+//----------------------------------------------------------------------
+// IntMoved
+//	Record where an integer now is in a heap.  Serves as the
+//	function to tell items their indexes, for testing Heaps.
+//----------------------------------------------------------------------
+
+static void
+IntMoved(int x, int i) {
+    heapIndex[x] = i;
+}
+
+//----------------------------------------------------------------------
+// IndexedHeapTest
+//	Test that a heap tells its items where they are, by taking each
+//	item out by its index in turn.
+//----------------------------------------------------------------------
+
+static void
+IndexedHeapTest(int *p, int numEntries) {
+    Heap<int> *heap = new Heap<int>(IntCompare, IntMoved);
+    int i, j;
+
+    for (i = 0; i < numEntries; i++)
+	heap->Insert(p[i]);
+    for (i = 0; i < numEntries; i++) {
+	for (j = i; j < numEntries; j++)
+	    ASSERT(heap->Item(heapIndex[p[j]]) == p[j]);
+	heap->RemoveAt(heapIndex[p[i]]);
+	ASSERT(heapIndex[p[i]] == -1);
+	heap->SanityCheck();
+    }
+    ASSERT(heap->IsEmpty());
+    delete heap;
+}
+
 // Array of values to be inserted into the HashTable
 // There are enough here to force a ReHash().
 static char *hashTestVector[] = { "0", "1", "2", "3", "4", "5", "6",
@@ -60,8 +101,8 @@ static char *hashTestVector[] = { "0", "1", "2", "3", "4", "5", "6",
 
 //----------------------------------------------------------------------
 // LibSelfTest
-//	Run self tests on bitmaps, lists, sorted lists, and 
-//	hash tables.
+//	Run self tests on bitmaps, lists, sorted lists, heaps, hash
+//	tables, and pools.
 //----------------------------------------------------------------------
 
 void
@@ -69,17 +110,24 @@ LibSelfTest () {
     Bitmap *map = new Bitmap(200);
     List<int> *list = new List<int>;
     SortedList<int> *sortList = new SortedList<int>(IntCompare);
+    Heap<int> *heap = new Heap<int>(IntCompare);
     HashTable<int, char *> *hashTable = 
 	new HashTable<int, char *>(HashKey, HashInt);
+    Pool *pool = new Pool("test", 24);
 	
 		
     map->SelfTest();
     list->SelfTest(listTestVector, sizeof(listTestVector)/sizeof(int));
     sortList->SelfTest(listTestVector, sizeof(listTestVector)/sizeof(int));
+    heap->SelfTest(listTestVector, sizeof(listTestVector)/sizeof(int));
+    IndexedHeapTest(listTestVector, sizeof(listTestVector)/sizeof(int));
     hashTable->SelfTest(hashTestVector, sizeof(hashTestVector)/sizeof(char *));
+    pool->SelfTest();
 
     delete map;
     delete list;
     delete sortList;
+    delete heap;
     delete hashTable;
+    delete pool;
 }
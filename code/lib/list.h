@@ -15,6 +15,7 @@
 
 #include "copyright.h"
 #include "debug.h"
+#include "pool.h"
 
 // The following class defines a "list element" -- which is
 // used to keep track of one item on a list.  It is equivalent to a
@@ -23,6 +24,9 @@
 //
 // This class is private to this module (and classes that inherit
 // from this module). Made public for notational convenience.
+//
+// List elements come and go with every Append and RemoveFront, so they
+// are allocated from the pools (see pool.h).
 
 template <class T>
 class ListElement {
@@ -30,6 +34,10 @@ class ListElement {
     ListElement(T itm); 	// initialize a list element
     ListElement *next;	     	// next element on list, NULL if this is last
     T item; 	   	     	// item on the list
+
+    void *operator new(size_t size) { return PoolAlloc(size); }
+    void operator delete(void *object, size_t size)
+				{ PoolFree(object, size); }
 };
 
 // The following class defines a "list" -- a singly linked list of
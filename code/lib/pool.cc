@@ -0,0 +1,249 @@
+// pool.cc
+//	Routines to allocate small objects from free lists (see pool.h).
+//
+//	An object on a free list holds the pointer to the next one in
+//	its first word, and a chunk likewise holds the pointer to the
+//	next chunk; the rest of a chunk is objects.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "debug.h"
+#include "pool.h"
+
+static Pool *allPools = NULL;	// every Pool, for PrintPools
+
+static Pool *sizeClasses[32];	// the Pools for PoolAlloc, by log2 of
+				// the size class, made as needed
+static int numLarge = 0;	// objects PoolAlloc has had to get
+				// from the host
+
+//----------------------------------------------------------------------
+// Pool::Pool
+// 	Initialize a pool, with nothing to hand out yet.  The first
+//	Alloc takes a chunk from the host.
+//
+//	"name" -- what the objects are, for printing
+//	"objectSize" -- bytes in each one
+//----------------------------------------------------------------------
+
+Pool::Pool(const char *name, int objectSize)
+{
+    int align = sizeof(void *);
+
+    ASSERT(objectSize > 0);
+    this->name = name;
+    this->objectSize = (objectSize + align - 1) / align * align;
+    perChunk = (PoolChunkSize - align) / this->objectSize;
+    if (perChunk < 1)
+	perChunk = 1;
+    freeList = NULL;
+    chunks = NULL;
+    numAllocs = numLive = maxLive = numChunks = 0;
+
+    next = allPools;
+    allPools = this;
+}
+
+Pool::~Pool()
+{
+    Pool **ptr;
+    void *chunk;
+
+    ASSERT(numLive == 0);
+    while (chunks != NULL) {
+	chunk = chunks;
+	chunks = *(void **) chunk;
+	delete [] (char *) chunk;
+    }
+    for (ptr = &allPools; *ptr != this; ptr = &(*ptr)->next)
+	;
+    *ptr = next;
+}
+
+//----------------------------------------------------------------------
+// Pool::Grow
+// 	Take a chunk from the host, and put its objects on the free list.
+//----------------------------------------------------------------------
+
+void
+Pool::Grow()
+{
+    int align = sizeof(void *);
+    char *chunk = new char[align + perChunk * objectSize];
+    char *object;
+
+    *(void **) chunk = chunks;
+    chunks = chunk;
+    numChunks++;
+    for (int i = perChunk - 1; i >= 0; i--) {	// so they go out in order
+	object = chunk + align + i * objectSize;
+	*(void **) object = freeList;
+	freeList = object;
+    }
+}
+
+//----------------------------------------------------------------------
+// Pool::Alloc
+// 	Return an object from the free list, growing the pool if the
+//	list is empty.  The object is not initialized.
+//----------------------------------------------------------------------
+
+void *
+Pool::Alloc()
+{
+    void *object;
+
+    if (freeList == NULL)
+	Grow();
+    object = freeList;
+    freeList = *(void **) object;
+    numAllocs++;
+    if (++numLive > maxLive)
+	maxLive = numLive;
+    return object;
+}
+
+//----------------------------------------------------------------------
+// Pool::Free
+// 	Put an object back on the free list, to be handed out again.
+//
+//	"object" -- an object returned by Alloc
+//----------------------------------------------------------------------
+
+void
+Pool::Free(void *object)
+{
+    ASSERT(numLive > 0);
+    *(void **) object = freeList;
+    freeList = object;
+    numLive--;
+}
+
+//----------------------------------------------------------------------
+// Pool::Print
+// 	Print how many objects the pool has handed out, and how fast,
+//	how many are still in use, and how much memory it took to do it.
+//
+//	"ticks" -- how much simulated time the allocations were made in
+//----------------------------------------------------------------------
+
+void
+Pool::Print(int ticks)
+{
+    cout << "Pool " << name << ": allocs " << numAllocs;
+    if (ticks > 0)
+	cout << " (" << (double) numAllocs * 1000 / ticks << " per 1000 ticks)";
+    cout << ", live " << numLive << ", peak " << maxLive;
+    cout << ", chunks " << numChunks << " of " << perChunk << "\n";
+}
+
+//----------------------------------------------------------------------
+// Pool::SelfTest
+//      Test whether this module is working: objects handed out at the
+//	same time don't overlap, and freed ones are reused.
+//----------------------------------------------------------------------
+
+void
+Pool::SelfTest()
+{
+    int num = perChunk + 1;		// enough to need a second chunk
+    char **objects = new char *[num];
+    int i, j;
+
+    ASSERT(numLive == 0);
+    for (i = 0; i < num; i++) {
+	objects[i] = (char *) Alloc();
+	memset(objects[i], i, objectSize);
+    }
+    ASSERT(numLive == num && numChunks >= 2);
+    for (i = 0; i < num; i++)
+	for (j = 0; j < objectSize; j++)
+	    ASSERT(objects[i][j] == (char) i);
+
+    Free(objects[0]);
+    ASSERT(Alloc() == objects[0]);	// last freed, first reused
+    for (i = 0; i < num; i++)
+	Free(objects[i]);
+    ASSERT(numLive == 0);
+    delete [] objects;
+}
+
+//----------------------------------------------------------------------
+// SizeClass
+// 	Return the log2 of the size class for an object of "size" bytes:
+//	the smallest power of two, no less than PoolMinSize, that holds it.
+//----------------------------------------------------------------------
+
+static int
+SizeClass(int size)
+{
+    int shift = 0;
+
+    while ((1 << shift) < size || (1 << shift) < PoolMinSize)
+	shift++;
+    return shift;
+}
+
+//----------------------------------------------------------------------
+// PoolAlloc
+// 	Return an object of "size" bytes, from the Pool for its size
+//	class, making the Pool if this is the first of that size.
+//	Larger objects than PoolMaxSize are simply allocated.
+//
+//	"size" -- bytes needed
+//----------------------------------------------------------------------
+
+void *
+PoolAlloc(int size)
+{
+    static char *names[32];
+    int shift;
+
+    if (size > PoolMaxSize) {
+	numLarge++;
+	return new char[size];
+    }
+    shift = SizeClass(size);
+    if (sizeClasses[shift] == NULL) {
+	names[shift] = new char[20];
+	sprintf(names[shift], "%d bytes", 1 << shift);
+	sizeClasses[shift] = new Pool(names[shift], 1 << shift);
+    }
+    return sizeClasses[shift]->Alloc();
+}
+
+//----------------------------------------------------------------------
+// PoolFree
+// 	Give back an object returned by PoolAlloc.
+//
+//	"object" -- the object
+//	"size" -- bytes asked for when it was allocated
+//----------------------------------------------------------------------
+
+void
+PoolFree(void *object, int size)
+{
+    if (size > PoolMaxSize)
+	delete [] (char *) object;
+    else
+	sizeClasses[SizeClass(size)]->Free(object);
+}
+
+//----------------------------------------------------------------------
+// PrintPools
+// 	Print the counts of every Pool, and of the objects too large
+//	for any of them.
+//
+//	"ticks" -- how much simulated time the allocations were made in
+//----------------------------------------------------------------------
+
+void
+PrintPools(int ticks)
+{
+    for (Pool *pool = allPools; pool != NULL; pool = pool->next)
+	pool->Print(ticks);
+    cout << "Pool none: allocs " << numLarge << " too large for a pool\n";
+}
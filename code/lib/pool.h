@@ -0,0 +1,85 @@
+// pool.h
+//	Data structures to allocate small objects quickly.
+//
+//	The kernel allocates and frees some small objects all the time:
+//	a ListElement for every item put on a list, a PendingInterrupt
+//	for every interrupt scheduled, a buffer for every file read.
+//	A Pool hands out objects of one size from a free list, carved
+//	out of large chunks taken from the host a few at a time, so that
+//	neither allocating nor freeing one goes to malloc.  Freed objects
+//	are kept for reuse, and the chunks are never given back.
+//
+//	A class with objects of its own to allocate can keep a Pool of
+//	its own (see PendingInterrupt).  Otherwise, PoolAlloc and PoolFree
+//	share a Pool for each size class, a power of two from 16 bytes
+//	up to PoolMaxSize; anything larger goes straight to the host.
+//
+//	Each Pool counts its objects, and with "-pools", Nachos prints
+//	the counts when it halts.
+//
+//     	NOTE: Mutual exclusion must be provided by the caller, as for
+//	lists; a thread can't be switched in the middle of an allocation.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef POOL_H
+#define POOL_H
+
+#include "copyright.h"
+#include "utility.h"
+
+const int PoolMinSize = 16;	// the smallest size class
+const int PoolMaxSize = 4096;	// the largest; PoolAlloc gives larger
+				// objects their own memory
+const int PoolChunkSize = 8192;	// bytes to take from the host at once,
+				// for objects no larger than this
+
+// The following class defines a pool of objects of one size.
+
+class Pool {
+  public:
+    Pool(const char *name, int objectSize);
+    				// initialize an empty pool
+    ~Pool();			// give back all the chunks; every object
+				// must have been freed
+
+    void *Alloc();		// an object, from the free list
+    void Free(void *object);	// put an object back on the free list
+
+    void Print(int ticks);	// print the counts, after "ticks" of
+				// simulated time
+    void SelfTest();		// verify module is working
+
+  private:
+    const char *name;		// for printing
+    int objectSize;		// bytes in each object, rounded up to
+				// a multiple of the size of a pointer
+    int perChunk;		// objects in each chunk
+    void *freeList;		// objects to hand out, each holding a
+				// pointer to the next
+    void *chunks;		// the chunks, each holding a pointer
+				// to the next in its first word
+
+    int numAllocs;		// objects handed out
+    int numLive;		// objects handed out and not yet freed
+    int maxLive;		// the most there have been at once
+    int numChunks;		// chunks taken from the host
+
+    void Grow();		// carve a new chunk into free objects
+
+    Pool *next;			// the next on the list of all pools,
+    friend void PrintPools(int ticks);	// for printing
+};
+
+extern void *PoolAlloc(int size);
+				// an object of "size" bytes, from the
+				// Pool for its size class
+extern void PoolFree(void *object, int size);
+				// give back an object from PoolAlloc,
+				// of the same "size"
+extern void PrintPools(int ticks);
+				// print the counts of every Pool
+
+#endif // POOL_H
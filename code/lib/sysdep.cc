@@ -32,6 +32,7 @@
 #include "sys/file.h"
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <poll.h>
 
 #ifdef SOLARIS
 // KMS
@@ -307,6 +308,53 @@ PollFile(int fd)
     return TRUE;
 }
 
+//----------------------------------------------------------------------
+// WaitForFiles
+// 	Put the UNIX process running Nachos to sleep until one of several
+//	open files or sockets has characters that can be read, or until
+//	a time limit runs out.  Unlike PollFile, this doesn't care how
+//	many files there are, or how large their descriptors.
+//
+//	Returns TRUE if there are characters to be read.
+//
+//	"fds" -- the file descriptors of the files to wait for
+//	"numFds" -- how many there are (there may be none)
+//	"msec" -- the most milliseconds to wait, or -1 to wait for input
+//		however long it takes
+//----------------------------------------------------------------------
+
+bool
+WaitForFiles(int *fds, int numFds, int msec)
+{
+    struct pollfd *polls = new struct pollfd[numFds + 1];
+    int retVal;
+
+    for (int i = 0; i < numFds; i++) {
+	polls[i].fd = fds[i];
+	polls[i].events = POLLIN;
+	polls[i].revents = 0;
+    }
+    retVal = poll(polls, numFds, msec);	// < 0 if interrupted by a
+						// signal; just give up
+    delete [] polls;
+    return retVal > 0;
+}
+
+//----------------------------------------------------------------------
+// HostTime
+// 	Return the time on the host, in seconds (to the microsecond)
+//	since some fixed moment, for measuring how long things take.
+//----------------------------------------------------------------------
+
+double
+HostTime()
+{
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+    return now.tv_sec + now.tv_usec / 1000000.0;
+}
+
 //----------------------------------------------------------------------
 // OpenForWrite
 // 	Open a file for writing.  Create it if it doesn't exist; truncate it 
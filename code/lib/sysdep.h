@@ -40,6 +40,13 @@ extern void DeallocBoundedArray(char *p, int size);
 // If no characters in the file, return without waiting.
 extern bool PollFile(int fd);
 
+// Wait until one of several files has characters to be read, or for
+// "msec" milliseconds (-1 to wait as long as it takes).
+extern bool WaitForFiles(int *fds, int numFds, int msec);
+
+// The time on the host, in seconds since some fixed moment.
+extern double HostTime();
+
 // File operations: open/read/write/lseek/close, and check for error
 // For simulating the disk and the console devices.
 extern int OpenForWrite(char *name);
@@ -0,0 +1,1066 @@
+// blocksim.cc -- run user programs a basic block at a time
+//
+//	The simulator in mipssim.cc goes through fetch, dispatch and a
+//	clock tick for every single instruction.  The block engine here
+//	instead translates each basic block (a run of instructions that
+//	ends with a branch or jump and its delay slot) once, into an array
+//	of operations whose register operands have already been resolved
+//	to addresses.  A block is then run with one indirect jump per
+//	instruction (with gcc's "labels as values"; otherwise with a
+//	switch), and simulated time is charged once for the whole block.
+//
+//	The results are exactly the same as with the interpreter:
+//
+//	   a block is only started if it will finish before the next
+//	   interrupt is due (see Interrupt::QuietTicks); otherwise we
+//	   run OneInstruction, so interrupts still happen between the
+//	   same two instructions;
+//
+//	   if an instruction traps to the kernel, the clock and the
+//	   program counters are first brought up to date (LeaveBlock),
+//	   and the rest of the block is abandoned once the kernel returns;
+//
+//	   instructions that are rare, or that can overflow, are not
+//	   translated, but are run by ExecuteInstruction in the middle
+//	   of the block.
+//
+//	Blocks are looked up by the physical address of their first
+//	instruction, and hang off the DecodedPage for that address.
+//	Storing into a block retires it.  A thread can trap out of the
+//	middle of a block, and we can't free the block until it has
+//	left it, so retired blocks are only freed between blocks.
+//
+//	Only the linear page table is supported; with a TLB, every
+//	instruction fetch has to update the TLB statistics, so Run
+//	just uses the interpreter.
+//
+//	If a library of blocks compiled ahead of time has been loaded
+//	(see native.h), a block it has compiled code for is run by that
+//	code instead of by ExecuteBlock.  Compiled blocks are found,
+//	retired and charged for just like the others.
+
+#include "copyright.h"
+
+#include "debug.h"
+#include "machine.h"
+#include "mipssim.h"
+#include "native.h"
+#include "main.h"
+
+#ifdef __GNUC__
+#define THREADED_CODE // dispatch through a table of label addresses
+#endif
+
+// The operations a block can contain.  The instructions that don't
+// have an operation of their own are run by GENERIC.
+
+enum BlockOpKind
+{
+	B_GENERIC, B_END, B_END_BRANCH,
+	B_ADDU, B_ADDIU, B_SUBU, B_AND, B_ANDI, B_OR, B_ORI,
+	B_XOR, B_XORI, B_NOR, B_SLT, B_SLTI, B_SLTU, B_SLTIU,
+	B_SLL, B_SRA, B_SLLV, B_SRAV, B_LUI, B_MOVE,
+	B_LB, B_LBU, B_LH, B_LHU, B_LW, B_SB, B_SH, B_SW,
+	B_BEQ, B_BNE, B_BLEZ, B_BGTZ, B_BLTZ, B_BGEZ, B_BLTZAL, B_BGEZAL,
+	B_J, B_JAL, B_JR, B_JALR,
+	NumBlockOpKinds
+};
+
+// Where operations that write R0 put their result.
+static int discarded;
+
+// The following class defines one operation of a translated block.
+
+class BlockOp
+{
+public:
+	void *handler;		// where to jump to run the operation
+	BlockOpKind kind;	// what the operation does
+	int *dst;			// register to write the result to
+	int *src1, *src2;	// registers to read the operands from
+	int dstReg;			// number of dst, for delayed loads
+	bool loadPending;	// might a delayed load be pending when the
+						// operation ends? (see TranslateBlock)
+	int imm;			// immediate operand, shift amount,
+						// or where a branch goes to if taken
+	int pc;				// virtual address of the instruction
+	int index;			// position of the operation in the block
+	bool delaySlot;		// is this the delay slot of a branch?
+	Instruction *instr; // the decoded instruction, for B_GENERIC
+};
+
+// The following class defines a translated basic block: its operations,
+// one per instruction, followed by a B_END or B_END_BRANCH operation.
+
+class TranslatedBlock
+{
+public:
+	TranslatedBlock(int addr, int maxInstrs);
+	~TranslatedBlock();
+
+	int virtAddr;	// virtual address of the first instruction
+	int numInstrs;	// number of instructions (so, of ticks) in the block
+	int numWords;	// number of words of memory the translation
+					// looked at; writing any of them retires the block
+	BlockOp *ops;	// the operations
+	bool bound;		// have the handlers been filled in yet?
+	const NativeBlock *native; // compiled code for the block, or NULL
+};
+
+// The following structure is what a compiled block is run with: the
+// context it is given, and what NativeStep needs to get from it.
+
+struct NativeRun
+{
+	NativeContext context; // must come first
+	Machine *machine;
+	TranslatedBlock *block;
+};
+
+//----------------------------------------------------------------------
+// TranslatedBlock::TranslatedBlock
+// 	Allocate an empty block, with room for "maxInstrs" instructions.
+//----------------------------------------------------------------------
+
+TranslatedBlock::TranslatedBlock(int addr, int maxInstrs)
+{
+	virtAddr = addr;
+	numInstrs = 0;
+	numWords = 0;
+	ops = new BlockOp[maxInstrs + 1];
+	bound = FALSE;
+	native = NULL;
+}
+
+TranslatedBlock::~TranslatedBlock()
+{
+	delete[] ops;
+}
+
+//----------------------------------------------------------------------
+// IsBranch
+// 	Return TRUE if the instruction is a branch or a jump, and so is
+//	followed by a delay slot.
+//----------------------------------------------------------------------
+
+static bool
+IsBranch(Instruction *instr)
+{
+	switch (instr->opCode)
+	{
+	case OP_BEQ:
+	case OP_BNE:
+	case OP_BLEZ:
+	case OP_BGTZ:
+	case OP_BLTZ:
+	case OP_BGEZ:
+	case OP_BLTZAL:
+	case OP_BGEZAL:
+	case OP_J:
+	case OP_JAL:
+	case OP_JR:
+	case OP_JALR:
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+//----------------------------------------------------------------------
+// IsLoad
+// 	Return TRUE if the instruction is a load, and so leaves a delayed
+//	load pending.
+//----------------------------------------------------------------------
+
+static bool
+IsLoad(Instruction *instr)
+{
+	switch (instr->opCode)
+	{
+	case OP_LB:
+	case OP_LBU:
+	case OP_LH:
+	case OP_LHU:
+	case OP_LW:
+	case OP_LWL:
+	case OP_LWR:
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+//----------------------------------------------------------------------
+// SetOp
+// 	Fill in what an operation does, and what it operates on.
+//----------------------------------------------------------------------
+
+static void
+SetOp(BlockOp *op, BlockOpKind kind, int *dst, int *src1, int *src2, int imm)
+{
+	op->kind = kind;
+	op->dst = dst;
+	op->src1 = src1;
+	op->src2 = src2;
+	op->imm = imm;
+}
+
+//----------------------------------------------------------------------
+// Machine::RunBlocks
+// 	Simulate the execution of a user-level program, a basic block at
+//	a time.  Called by Run; never returns.
+//
+//	Whenever a block can't be used -- we are in the delay slot of a
+//	branch, the PC can't be translated, the instructions at the PC
+//	can't be made into a block, or an interrupt is due before the
+//	block would finish -- we run one instruction with the interpreter
+//	instead, and try again.
+//----------------------------------------------------------------------
+
+void Machine::RunBlocks()
+{
+	TranslatedBlock *block;
+
+	for (;;)
+	{
+		if (!retiredBlocks->IsEmpty())
+			FreeRetiredBlocks();
+
+		block = NULL;
+		if (registers[NextPCReg] == registers[PCReg] + 4)
+			block = FindBlock(registers[PCReg]);
+		if (block != NULL && block->numInstrs > 0 &&
+			block->numInstrs * UserTick <= kernel->interrupt->QuietTicks())
+		{
+			ExecuteBlock(block);
+		}
+		else
+		{
+			OneInstruction<FastPolicy>();
+			kernel->interrupt->OneTick();
+		}
+	}
+}
+
+//----------------------------------------------------------------------
+// Machine::FindBlock
+// 	Return the block starting at a virtual address, translating it
+//	if it hasn't been already.  Return NULL if the address can't be
+//	translated; the interpreter will raise the exception.
+//
+//	"virtAddr" -- the address of the first instruction of the block
+//----------------------------------------------------------------------
+
+TranslatedBlock *
+Machine::FindBlock(int virtAddr)
+{
+	int physAddr;
+	DecodedPage *page;
+	TranslatedBlock *block;
+	int index;
+	char *host;
+
+	host = QuickTranslate(virtAddr, 4, FALSE);
+	if (host != NULL)
+		physAddr = host - mainMemory;
+	else if (Translate(virtAddr, &physAddr, 4, FALSE) == NoException)
+		FillSoftTLB(virtAddr);
+	else
+		return NULL;
+
+	(void)DecodeWord(physAddr); // make sure the page is there
+	page = decodeCache[physAddr / PageSize];
+	if (page->blocks == NULL)
+	{
+		page->blocks = new TranslatedBlock *[PageSize / 4];
+		for (int i = 0; i < PageSize / 4; i++)
+			page->blocks[i] = NULL;
+	}
+
+	index = (physAddr % PageSize) / 4;
+	block = page->blocks[index];
+	if (block != NULL && block->virtAddr == virtAddr)
+		return block;
+
+	if (block != NULL)
+	{ // the page is mapped somewhere else now
+		retiredBlocks->Append(block);
+		blocksRetired = TRUE;
+	}
+	block = TranslateBlock(virtAddr, physAddr);
+	page->blocks[index] = block;
+	return block;
+}
+
+//----------------------------------------------------------------------
+// Machine::TranslateBlock
+// 	Translate the basic block starting at a virtual address.  The
+//	block goes up to and including the first branch or jump, and the
+//	instruction in its delay slot, but never past the end of the page.
+//	If the branch's delay slot is on the next page, or is itself a
+//	branch, the block stops just before the branch.  The block may be
+//	empty, in which case the interpreter is used for the instruction.
+//
+//	"virtAddr" -- the address of the first instruction of the block
+//	"physAddr" -- the same, translated
+//----------------------------------------------------------------------
+
+TranslatedBlock *
+Machine::TranslateBlock(int virtAddr, int physAddr)
+{
+	int numWords = (PageSize - physAddr % PageSize) / 4;
+	TranslatedBlock *block = new TranslatedBlock(virtAddr, numWords);
+	Instruction *instr;
+	BlockOp *op;
+	int n = 0; // the block is instructions [0, n)
+	bool branch = FALSE;
+
+	for (int i = 0; i < numWords; i++)
+	{
+		instr = DecodeWord(physAddr + i * 4);
+		block->numWords = i + 1;
+		if (!IsBranch(instr))
+		{
+			n = i + 1;
+			continue;
+		}
+		// take the branch and its delay slot, if we can
+		if (i + 1 < numWords)
+		{
+			block->numWords = i + 2;
+			if (!IsBranch(DecodeWord(physAddr + i * 4 + 4)))
+			{
+				n = i + 2;
+				branch = TRUE;
+			}
+		}
+		break;
+	}
+
+	for (int i = 0; i < n; i++)
+	{
+		int *r = registers;
+		int pc = virtAddr + i * 4;
+
+		instr = DecodeWord(physAddr + i * 4);
+		int rs = instr->rs, rt = instr->rt, rd = instr->rd;
+
+		op = &block->ops[i];
+		op->pc = pc;
+		op->index = i;
+		op->delaySlot = (branch && i == n - 1);
+		op->instr = instr;
+		op->dstReg = 0;
+		SetOp(op, B_GENERIC, NULL, NULL, NULL, 0);
+
+		switch (instr->opCode)
+		{
+		case OP_ADDU:
+			SetOp(op, B_ADDU, &r[rd], &r[rs], &r[rt], 0);
+			break;
+		case OP_ADDIU:
+			SetOp(op, B_ADDIU, &r[rt], &r[rs], NULL, instr->extra);
+			break;
+		case OP_SUBU:
+			SetOp(op, B_SUBU, &r[rd], &r[rs], &r[rt], 0);
+			break;
+		case OP_AND:
+			SetOp(op, B_AND, &r[rd], &r[rs], &r[rt], 0);
+			break;
+		case OP_ANDI:
+			SetOp(op, B_ANDI, &r[rt], &r[rs], NULL,
+				  instr->extra & 0xffff);
+			break;
+		case OP_OR:
+			SetOp(op, B_OR, &r[rd], &r[rs], &r[rt], 0);
+			break;
+		case OP_ORI:
+			SetOp(op, B_ORI, &r[rt], &r[rs], NULL,
+				  instr->extra & 0xffff);
+			break;
+		case OP_XOR:
+			SetOp(op, B_XOR, &r[rd], &r[rs], &r[rt], 0);
+			break;
+		case OP_XORI:
+			SetOp(op, B_XORI, &r[rt], &r[rs], NULL,
+				  instr->extra & 0xffff);
+			break;
+		case OP_NOR:
+			SetOp(op, B_NOR, &r[rd], &r[rs], &r[rt], 0);
+			break;
+		case OP_SLT:
+			SetOp(op, B_SLT, &r[rd], &r[rs], &r[rt], 0);
+			break;
+		case OP_SLTI:
+			SetOp(op, B_SLTI, &r[rt], &r[rs], NULL, instr->extra);
+			break;
+		case OP_SLTU:
+			SetOp(op, B_SLTU, &r[rd], &r[rs], &r[rt], 0);
+			break;
+		case OP_SLTIU:
+			SetOp(op, B_SLTIU, &r[rt], &r[rs], NULL, instr->extra);
+			break;
+
+		// ExecuteInstruction does SRL and SRLV through a signed int, so
+		// they come out the same as SRA and SRAV; keep it that way.
+		case OP_SLL:
+			SetOp(op, B_SLL, &r[rd], &r[rt], NULL, instr->extra);
+			break;
+		case OP_SRA:
+		case OP_SRL:
+			SetOp(op, B_SRA, &r[rd], &r[rt], NULL, instr->extra);
+			break;
+		case OP_SLLV:
+			SetOp(op, B_SLLV, &r[rd], &r[rt], &r[rs], 0);
+			break;
+		case OP_SRAV:
+		case OP_SRLV:
+			SetOp(op, B_SRAV, &r[rd], &r[rt], &r[rs], 0);
+			break;
+
+		case OP_LUI:
+			SetOp(op, B_LUI, &r[rt], NULL, NULL, instr->extra << 16);
+			break;
+		case OP_MFHI:
+			SetOp(op, B_MOVE, &r[rd], &r[HiReg], NULL, 0);
+			break;
+		case OP_MFLO:
+			SetOp(op, B_MOVE, &r[rd], &r[LoReg], NULL, 0);
+			break;
+		case OP_MTHI:
+			SetOp(op, B_MOVE, &r[HiReg], &r[rs], NULL, 0);
+			break;
+		case OP_MTLO:
+			SetOp(op, B_MOVE, &r[LoReg], &r[rs], NULL, 0);
+			break;
+
+		case OP_LB:
+			SetOp(op, B_LB, NULL, &r[rs], NULL, instr->extra);
+			op->dstReg = rt;
+			break;
+		case OP_LBU:
+			SetOp(op, B_LBU, NULL, &r[rs], NULL, instr->extra);
+			op->dstReg = rt;
+			break;
+		case OP_LH:
+			SetOp(op, B_LH, NULL, &r[rs], NULL, instr->extra);
+			op->dstReg = rt;
+			break;
+		case OP_LHU:
+			SetOp(op, B_LHU, NULL, &r[rs], NULL, instr->extra);
+			op->dstReg = rt;
+			break;
+		case OP_LW:
+			SetOp(op, B_LW, NULL, &r[rs], NULL, instr->extra);
+			op->dstReg = rt;
+			break;
+		case OP_SB:
+			SetOp(op, B_SB, NULL, &r[rs], &r[rt], instr->extra);
+			break;
+		case OP_SH:
+			SetOp(op, B_SH, NULL, &r[rs], &r[rt], instr->extra);
+			break;
+		case OP_SW:
+			SetOp(op, B_SW, NULL, &r[rs], &r[rt], instr->extra);
+			break;
+
+		// branches: "imm" is where we go if the branch is taken
+		case OP_BEQ:
+			SetOp(op, B_BEQ, NULL, &r[rs], &r[rt],
+				  pc + 4 + IndexToAddr(instr->extra));
+			break;
+		case OP_BNE:
+			SetOp(op, B_BNE, NULL, &r[rs], &r[rt],
+				  pc + 4 + IndexToAddr(instr->extra));
+			break;
+		case OP_BLEZ:
+			SetOp(op, B_BLEZ, NULL, &r[rs], NULL,
+				  pc + 4 + IndexToAddr(instr->extra));
+			break;
+		case OP_BGTZ:
+			SetOp(op, B_BGTZ, NULL, &r[rs], NULL,
+				  pc + 4 + IndexToAddr(instr->extra));
+			break;
+		case OP_BLTZ:
+			SetOp(op, B_BLTZ, NULL, &r[rs], NULL,
+				  pc + 4 + IndexToAddr(instr->extra));
+			break;
+		case OP_BGEZ:
+			SetOp(op, B_BGEZ, NULL, &r[rs], NULL,
+				  pc + 4 + IndexToAddr(instr->extra));
+			break;
+		case OP_BLTZAL:
+			SetOp(op, B_BLTZAL, &r[R31], &r[rs], NULL,
+				  pc + 4 + IndexToAddr(instr->extra));
+			break;
+		case OP_BGEZAL:
+			SetOp(op, B_BGEZAL, &r[R31], &r[rs], NULL,
+				  pc + 4 + IndexToAddr(instr->extra));
+			break;
+		case OP_J:
+			SetOp(op, B_J, NULL, NULL, NULL,
+				  ((pc + 8) & 0xf0000000) | IndexToAddr(instr->extra));
+			break;
+		case OP_JAL:
+			SetOp(op, B_JAL, &r[R31], NULL, NULL,
+				  ((pc + 8) & 0xf0000000) | IndexToAddr(instr->extra));
+			break;
+		case OP_JR:
+			SetOp(op, B_JR, NULL, &r[rs], NULL, 0);
+			break;
+		case OP_JALR:
+			SetOp(op, B_JALR, &r[rd], &r[rs], NULL, 0);
+			break;
+
+		default: // leave it to ExecuteInstruction
+			break;
+		}
+
+		// Only a load leaves a delayed load pending, so unless we don't
+		// know what came before, or it was a load, the operation has no
+		// load to finish.  Then nothing puts R0 back to zero after it,
+		// so its result goes nowhere instead -- except for a JALR, which
+		// reads its operand after writing its link.
+		op->loadPending =
+			(i == 0 || IsLoad(DecodeWord(physAddr + i * 4 - 4)));
+		if (op->dst == &r[0])
+		{
+			if (op->kind == B_JALR)
+				op->loadPending = TRUE;
+			else
+				op->dst = &discarded;
+		}
+	}
+
+	// the operation that ends the block; "pc" is that of the last
+	// instruction
+	op = &block->ops[n];
+	op->kind = branch ? B_END_BRANCH : B_END;
+	op->pc = virtAddr + (n - 1) * 4;
+	op->index = n;
+	op->delaySlot = FALSE;
+	op->instr = NULL;
+	block->numInstrs = n;
+
+	// use the compiled code for the block, if it was compiled from
+	// these very words
+	if (nativeCode != NULL && n > 0)
+	{
+		const NativeBlock *native = nativeCode->Find(virtAddr);
+
+		if (native != NULL && native->numInstrs == n &&
+			native->numWords == block->numWords &&
+			(native->branch != 0) == branch)
+		{
+			block->native = native;
+			for (int i = 0; i < block->numWords; i++)
+				if (DecodeWord(physAddr + i * 4)->value != native->words[i])
+				{
+					block->native = NULL;
+					break;
+				}
+		}
+	}
+	return block;
+}
+
+//----------------------------------------------------------------------
+// Machine::ExecuteBlock
+// 	Run a translated block from start to finish, unless one of its
+//	instructions traps to the kernel, or writes over a block.  The
+//	caller has checked that the block can run to the end without an
+//	interrupt becoming due, and that we're not in a delay slot.
+//
+//	Every operation ends the same way ExecuteInstruction does: by
+//	doing any delayed load -- though most know, from when they were
+//	translated, that there can't be one (see loadPending).  The program counters are only brought up
+//	to date when we leave the block, and on the way into the kernel
+//	(see LeaveBlock).
+//
+//	"block" -- the block to run
+//----------------------------------------------------------------------
+
+#ifdef THREADED_CODE
+#define CASE(kind) do_##kind:
+#define DISPATCH() goto *op->handler
+#else
+#define CASE(kind) case kind:
+#define DISPATCH() goto dispatch
+#endif
+
+// Do the delayed load that was pending, and set up the next one.
+#define FINISH_LOAD(reg, val)                                 \
+	{                                                         \
+		registers[registers[LoadReg]] = registers[LoadValueReg]; \
+		registers[LoadReg] = (reg);                           \
+		registers[LoadValueReg] = (val);                      \
+		registers[0] = 0;                                     \
+	}
+
+// Finish an operation that doesn't load anything, and go to the next one.
+#define NEXT()                     \
+	{                              \
+		if (op->loadPending)       \
+			FINISH_LOAD(0, 0);     \
+		op++;                      \
+		DISPATCH();                \
+	}
+
+void Machine::ExecuteBlock(TranslatedBlock *block)
+{
+#ifdef THREADED_CODE
+	static void *handlers[NumBlockOpKinds] = {
+		&&do_B_GENERIC, &&do_B_END, &&do_B_END_BRANCH,
+		&&do_B_ADDU, &&do_B_ADDIU, &&do_B_SUBU, &&do_B_AND, &&do_B_ANDI,
+		&&do_B_OR, &&do_B_ORI, &&do_B_XOR, &&do_B_XORI, &&do_B_NOR,
+		&&do_B_SLT, &&do_B_SLTI, &&do_B_SLTU, &&do_B_SLTIU,
+		&&do_B_SLL, &&do_B_SRA, &&do_B_SLLV, &&do_B_SRAV, &&do_B_LUI,
+		&&do_B_MOVE,
+		&&do_B_LB, &&do_B_LBU, &&do_B_LH, &&do_B_LHU, &&do_B_LW,
+		&&do_B_SB, &&do_B_SH, &&do_B_SW,
+		&&do_B_BEQ, &&do_B_BNE, &&do_B_BLEZ, &&do_B_BGTZ, &&do_B_BLTZ,
+		&&do_B_BGEZ, &&do_B_BLTZAL, &&do_B_BGEZAL,
+		&&do_B_J, &&do_B_JAL, &&do_B_JR, &&do_B_JALR};
+#endif
+	BlockOp *op = block->ops;
+	int value, reg;
+
+	if (block->native != NULL)
+	{
+		ExecuteNative(block);
+		return;
+	}
+
+#ifdef THREADED_CODE
+	if (!block->bound)
+	{
+		for (int i = 0; i <= block->numInstrs; i++)
+			block->ops[i].handler = handlers[block->ops[i].kind];
+		block->bound = TRUE;
+	}
+#endif
+
+	blocksRetired = FALSE;
+
+#ifdef THREADED_CODE
+	DISPATCH();
+#else
+dispatch:
+	switch (op->kind)
+	{
+#endif
+
+	CASE(B_ADDU)
+		*op->dst = *op->src1 + *op->src2;
+		NEXT();
+	CASE(B_ADDIU)
+		*op->dst = *op->src1 + op->imm;
+		NEXT();
+	CASE(B_SUBU)
+		*op->dst = *op->src1 - *op->src2;
+		NEXT();
+	CASE(B_AND)
+		*op->dst = *op->src1 & *op->src2;
+		NEXT();
+	CASE(B_ANDI)
+		*op->dst = *op->src1 & op->imm;
+		NEXT();
+	CASE(B_OR)
+		*op->dst = *op->src1 | *op->src2;
+		NEXT();
+	CASE(B_ORI)
+		*op->dst = *op->src1 | op->imm;
+		NEXT();
+	CASE(B_XOR)
+		*op->dst = *op->src1 ^ *op->src2;
+		NEXT();
+	CASE(B_XORI)
+		*op->dst = *op->src1 ^ op->imm;
+		NEXT();
+	CASE(B_NOR)
+		*op->dst = ~(*op->src1 | *op->src2);
+		NEXT();
+	CASE(B_SLT)
+		*op->dst = (*op->src1 < *op->src2);
+		NEXT();
+	CASE(B_SLTI)
+		*op->dst = (*op->src1 < op->imm);
+		NEXT();
+	CASE(B_SLTU)
+		*op->dst = ((unsigned int)*op->src1 < (unsigned int)*op->src2);
+		NEXT();
+	CASE(B_SLTIU)
+		*op->dst = ((unsigned int)*op->src1 < (unsigned int)op->imm);
+		NEXT();
+	CASE(B_SLL)
+		*op->dst = *op->src1 << op->imm;
+		NEXT();
+	CASE(B_SRA)
+		*op->dst = *op->src1 >> op->imm;
+		NEXT();
+	CASE(B_SLLV)
+		*op->dst = *op->src1 << (*op->src2 & 0x1f);
+		NEXT();
+	CASE(B_SRAV)
+		*op->dst = *op->src1 >> (*op->src2 & 0x1f);
+		NEXT();
+	CASE(B_LUI)
+		*op->dst = op->imm;
+		NEXT();
+	CASE(B_MOVE)
+		*op->dst = *op->src1;
+		NEXT();
+
+	// Loads and stores may trap.  If the kernel fixes up the page
+	// fault, ReadMem and WriteMem go on to do the access; either way,
+	// "op" may have been freed by the time they return.
+	CASE(B_LB)
+		reg = op->dstReg;
+		blockOp = op;
+		if (!ReadMem(*op->src1 + op->imm, 1, &value))
+			goto trapped;
+		value = (value & 0x80) ? (value | 0xffffff00) : (value & 0xff);
+		goto loaded;
+	CASE(B_LBU)
+		reg = op->dstReg;
+		blockOp = op;
+		if (!ReadMem(*op->src1 + op->imm, 1, &value))
+			goto trapped;
+		value &= 0xff;
+		goto loaded;
+	CASE(B_LH)
+		reg = op->dstReg;
+		blockOp = op;
+		if (!ReadMem(*op->src1 + op->imm, 2, &value))
+			goto trapped;
+		value = (value & 0x8000) ? (value | 0xffff0000) : (value & 0xffff);
+		goto loaded;
+	CASE(B_LHU)
+		reg = op->dstReg;
+		blockOp = op;
+		if (!ReadMem(*op->src1 + op->imm, 2, &value))
+			goto trapped;
+		value &= 0xffff;
+		goto loaded;
+	CASE(B_LW)
+		reg = op->dstReg;
+		blockOp = op;
+		if (!ReadMem(*op->src1 + op->imm, 4, &value))
+			goto trapped;
+	loaded:
+		FINISH_LOAD(reg, value);
+		if (blockOp == NULL)
+			goto recovered;
+		op++;
+		DISPATCH();
+
+	CASE(B_SB)
+		blockOp = op;
+		if (!WriteMem((unsigned)(*op->src1 + op->imm), 1, *op->src2))
+			goto trapped;
+		goto stored;
+	CASE(B_SH)
+		blockOp = op;
+		if (!WriteMem((unsigned)(*op->src1 + op->imm), 2, *op->src2))
+			goto trapped;
+		goto stored;
+	CASE(B_SW)
+		blockOp = op;
+		if (!WriteMem((unsigned)(*op->src1 + op->imm), 4, *op->src2))
+			goto trapped;
+	stored:
+		FINISH_LOAD(0, 0);
+		if (blockOp == NULL)
+			goto recovered;
+		if (blocksRetired)
+			goto modified;
+		op++;
+		DISPATCH();
+
+	// Branches just work out where to go; the block ends after the
+	// delay slot.
+	CASE(B_BEQ)
+		blockTarget = (*op->src1 == *op->src2) ? op->imm : op->pc + 8;
+		NEXT();
+	CASE(B_BNE)
+		blockTarget = (*op->src1 != *op->src2) ? op->imm : op->pc + 8;
+		NEXT();
+	CASE(B_BLEZ)
+		blockTarget = (*op->src1 <= 0) ? op->imm : op->pc + 8;
+		NEXT();
+	CASE(B_BGTZ)
+		blockTarget = (*op->src1 > 0) ? op->imm : op->pc + 8;
+		NEXT();
+	CASE(B_BLTZAL)
+		*op->dst = op->pc + 8;
+	CASE(B_BLTZ)
+		blockTarget = (*op->src1 & SIGN_BIT) ? op->imm : op->pc + 8;
+		NEXT();
+	CASE(B_BGEZAL)
+		*op->dst = op->pc + 8;
+	CASE(B_BGEZ)
+		blockTarget = !(*op->src1 & SIGN_BIT) ? op->imm : op->pc + 8;
+		NEXT();
+	CASE(B_JAL)
+		*op->dst = op->pc + 8;
+	CASE(B_J)
+		blockTarget = op->imm;
+		NEXT();
+	CASE(B_JALR)
+		*op->dst = op->pc + 8;
+	CASE(B_JR)
+		blockTarget = *op->src1;
+		NEXT();
+
+	CASE(B_GENERIC)
+		registers[PCReg] = op->pc;
+		registers[NextPCReg] = op->delaySlot ? blockTarget : op->pc + 4;
+		if (op->index > 0)
+			registers[PrevPCReg] = op->pc - 4;
+		blockOp = op;
+		ExecuteInstruction<FastPolicy>(op->instr); // does the delayed load, and
+									   // advances the PC
+		if (blockOp == NULL)
+			goto trapped;
+		if (blocksRetired)
+		{
+			blockOp = NULL;
+			kernel->interrupt->AdvanceQuietly((op->index + 1) * UserTick);
+			return;
+		}
+		op++;
+		DISPATCH();
+
+	CASE(B_END)
+		registers[PrevPCReg] = op->pc;
+		registers[PCReg] = op->pc + 4;
+		registers[NextPCReg] = op->pc + 8;
+		blockOp = NULL;
+		kernel->interrupt->AdvanceQuietly(op->index * UserTick);
+		return;
+	CASE(B_END_BRANCH)
+		registers[PrevPCReg] = op->pc;
+		registers[PCReg] = blockTarget;
+		registers[NextPCReg] = blockTarget + 4;
+		blockOp = NULL;
+		kernel->interrupt->AdvanceQuietly(op->index * UserTick);
+		return;
+
+#ifndef THREADED_CODE
+	default:
+		ASSERT(FALSE);
+	}
+#endif
+
+modified:
+	// The store wrote over a block, maybe this one: stop after it.
+	registers[PrevPCReg] = op->pc;
+	registers[PCReg] = op->delaySlot ? blockTarget : op->pc + 4;
+	registers[NextPCReg] = registers[PCReg] + 4;
+	blockOp = NULL;
+	kernel->interrupt->AdvanceQuietly((op->index + 1) * UserTick);
+	return;
+
+recovered:
+	// The instruction trapped, but was done once the kernel returned;
+	// advance the program counters as ExecuteInstruction would.
+	registers[PrevPCReg] = registers[PCReg];
+	registers[PCReg] = registers[NextPCReg];
+	registers[NextPCReg] = registers[PCReg] + 4;
+
+trapped:
+	// LeaveBlock has already charged for the instructions before this
+	// one; this one gets its tick the same way as in Run.
+	kernel->interrupt->OneTick();
+}
+
+//----------------------------------------------------------------------
+// Machine::LeaveBlock
+// 	Called by RaiseException.  If we are trapping out of the middle of
+//	a block, bring the program counters and simulated time up to date,
+//	so that the kernel sees exactly what it would have seen running
+//	one instruction at a time.  Clearing "blockOp" also tells the
+//	block that it has to stop.
+//----------------------------------------------------------------------
+
+void Machine::LeaveBlock()
+{
+	BlockOp *op = blockOp;
+
+	if (op == NULL)
+		return; // not in a block
+	blockOp = NULL;
+
+	registers[PCReg] = op->pc;
+	registers[NextPCReg] = op->delaySlot ? blockTarget : op->pc + 4;
+	if (op->index > 0)
+		registers[PrevPCReg] = op->pc - 4;
+	kernel->interrupt->AdvanceQuietly(op->index * UserTick);
+}
+
+//----------------------------------------------------------------------
+// Machine::ExecuteNative
+// 	Run a block by calling the code compiled for it.  The compiled
+//	code calls NativeStep for the instructions it doesn't do itself;
+//	if one of them stops the block, NativeStep has already brought
+//	everything up to date.  Otherwise the block ends as in ExecuteBlock.
+//
+//	"block" -- the block to run
+//----------------------------------------------------------------------
+
+void Machine::ExecuteNative(TranslatedBlock *block)
+{
+	NativeRun run;
+	BlockOp *end = &block->ops[block->numInstrs];
+
+	run.context.target = 0;
+	run.context.step = NativeStep;
+	run.machine = this;
+	run.block = block;
+
+	blocksRetired = FALSE;
+	if (!(*block->native->run)(&run.context, registers))
+		return;
+
+	registers[PrevPCReg] = end->pc;
+	if (end->kind == B_END_BRANCH)
+		registers[PCReg] = run.context.target;
+	else
+		registers[PCReg] = end->pc + 4;
+	registers[NextPCReg] = registers[PCReg] + 4;
+	blockOp = NULL;
+	kernel->interrupt->AdvanceQuietly(end->index * UserTick);
+}
+
+//----------------------------------------------------------------------
+// Machine::NativeStep
+// 	Run one instruction of a compiled block for it, the way ExecuteBlock
+//	would: loads and stores directly, anything else with
+//	ExecuteInstruction.  Called by the compiled code.
+//
+//	Returns 1 if the block can go on, or 0 if it must stop: the
+//	instruction trapped, or wrote over a block.  Either way, the
+//	registers and the clock have been brought up to date.
+//
+//	"context" -- what the block was run with (see ExecuteNative)
+//	"index" -- which instruction of the block
+//----------------------------------------------------------------------
+
+int Machine::NativeStep(NativeContext *context, int index)
+{
+	NativeRun *run = (NativeRun *)context;
+	Machine *machine = run->machine;
+	int *registers = machine->registers;
+	BlockOp *op = &run->block->ops[index];
+	int value, size;
+
+	machine->blockTarget = context->target; // for LeaveBlock
+	machine->blockOp = op;
+	switch (op->kind)
+	{
+	case B_LB:
+	case B_LBU:
+	case B_LH:
+	case B_LHU:
+	case B_LW:
+		size = (op->kind == B_LW) ? 4 : (op->kind >= B_LH) ? 2 : 1;
+		if (!machine->ReadMem(*op->src1 + op->imm, size, &value))
+			break; // trapped
+		if (op->kind == B_LB)
+			value = (value & 0x80) ? (value | 0xffffff00) : (value & 0xff);
+		else if (op->kind == B_LH)
+			value = (value & 0x8000) ? (value | 0xffff0000) : (value & 0xffff);
+		FINISH_LOAD(op->dstReg, value);
+		if (machine->blockOp != NULL)
+			return 1;
+		// the kernel fixed up a fault, and the load was done; advance
+		// the program counters as ExecuteInstruction would
+		registers[PrevPCReg] = registers[PCReg];
+		registers[PCReg] = registers[NextPCReg];
+		registers[NextPCReg] = registers[PCReg] + 4;
+		break;
+
+	case B_SB:
+	case B_SH:
+	case B_SW:
+		size = (op->kind == B_SW) ? 4 : (op->kind == B_SH) ? 2 : 1;
+		if (!machine->WriteMem((unsigned)(*op->src1 + op->imm), size,
+							   *op->src2))
+			break; // trapped
+		FINISH_LOAD(0, 0);
+		if (machine->blockOp == NULL)
+		{ // recovered, as for loads
+			registers[PrevPCReg] = registers[PCReg];
+			registers[PCReg] = registers[NextPCReg];
+			registers[NextPCReg] = registers[PCReg] + 4;
+			break;
+		}
+		if (!machine->blocksRetired)
+			return 1;
+		// the store wrote over a block, maybe this one: stop after it
+		registers[PrevPCReg] = op->pc;
+		registers[PCReg] = op->delaySlot ? context->target : op->pc + 4;
+		registers[NextPCReg] = registers[PCReg] + 4;
+		machine->blockOp = NULL;
+		kernel->interrupt->AdvanceQuietly((index + 1) * UserTick);
+		return 0;
+
+	default:
+		registers[PCReg] = op->pc;
+		registers[NextPCReg] = op->delaySlot ? context->target : op->pc + 4;
+		if (index > 0)
+			registers[PrevPCReg] = op->pc - 4;
+		machine->ExecuteInstruction<FastPolicy>(op->instr);
+		if (machine->blockOp == NULL)
+			break; // trapped
+		if (!machine->blocksRetired)
+			return 1;
+		machine->blockOp = NULL;
+		kernel->interrupt->AdvanceQuietly((index + 1) * UserTick);
+		return 0;
+	}
+
+	// The instruction trapped.  LeaveBlock has already charged for the
+	// instructions before this one; this one gets its tick as in Run.
+	kernel->interrupt->OneTick();
+	return 0;
+}
+
+//----------------------------------------------------------------------
+// Machine::RetireBlocks
+// 	Stop using the blocks in a page whose translation looked at a
+//	word that has just been written.  They are freed later, by
+//	FreeRetiredBlocks, in case a thread is still in one of them.
+//
+//	"page" -- the page the word is in
+//	"index" -- which word of the page, or -1 for all of them
+//----------------------------------------------------------------------
+
+void Machine::RetireBlocks(DecodedPage *page, int index)
+{
+	TranslatedBlock *block;
+
+	for (int i = 0; i < PageSize / 4; i++)
+	{
+		block = page->blocks[i];
+		if (block != NULL &&
+			(index < 0 || (i <= index && index < i + block->numWords)))
+		{
+			page->blocks[i] = NULL;
+			retiredBlocks->Append(block);
+			blocksRetired = TRUE;
+		}
+	}
+}
+
+//----------------------------------------------------------------------
+// Machine::FreeRetiredBlocks
+// 	De-allocate the blocks that have been retired.  Must only be
+//	called when no thread can be in the middle of one.
+//----------------------------------------------------------------------
+
+void Machine::FreeRetiredBlocks()
+{
+	while (!retiredBlocks->IsEmpty())
+		delete retiredBlocks->RemoveFront();
+}
@@ -0,0 +1,78 @@
+// cache.cc
+//	Routines to simulate a set-associative cache (see cache.h).
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "debug.h"
+#include "cache.h"
+
+//----------------------------------------------------------------------
+// Cache::Cache
+// 	Initialize an empty cache.
+//
+//	"size" -- bytes in the cache
+//	"ways" -- lines in each set
+//	"lineSize" -- bytes in each line; a power of 2, at least a word
+//	"missPenalty" -- ticks to charge for each miss
+//----------------------------------------------------------------------
+
+Cache::Cache(int size, int ways, int lineSize, int missPenalty)
+{
+    ASSERT(lineSize >= 4 && (lineSize & (lineSize - 1)) == 0);
+    ASSERT(ways > 0 && size > 0 && size % (ways * lineSize) == 0);
+    ASSERT(missPenalty >= 0);
+
+    for (lineShift = 0; (1 << lineShift) < lineSize; lineShift++)
+	;
+    this->ways = ways;
+    this->missPenalty = missPenalty;
+    numSets = size / (ways * lineSize);
+    tags = new int[numSets * ways];
+    usedAt = new unsigned int[numSets * ways];
+    for (int i = 0; i < numSets * ways; i++) {
+	tags[i] = -1;
+	usedAt[i] = 0;
+    }
+    accesses = 0;
+}
+
+Cache::~Cache()
+{
+    delete[] tags;
+    delete[] usedAt;
+}
+
+//----------------------------------------------------------------------
+// Cache::Access
+// 	Look for the line holding a physical address in its set.  If it
+//	isn't there, load it, in place of the least recently used line.
+//
+//	Returns TRUE on a hit, FALSE on a miss.
+//
+//	"physAddr" -- the address being read or written; the access must
+//		not cross a line
+//----------------------------------------------------------------------
+
+bool
+Cache::Access(int physAddr)
+{
+    int line = (unsigned)physAddr >> lineShift;
+    int first = (line % numSets) * ways;
+    int victim = first;
+
+    accesses++;
+    for (int i = first; i < first + ways; i++) {
+	if (tags[i] == line) {
+	    usedAt[i] = accesses;
+	    return TRUE;
+	}
+	if (usedAt[i] < usedAt[victim])
+	    victim = i;
+    }
+    tags[victim] = line;
+    usedAt[victim] = accesses;
+    return FALSE;
+}
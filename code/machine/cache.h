@@ -0,0 +1,58 @@
+// cache.h
+//	Data structures for simulating the processor's level 1 caches.
+//
+//	Nachos normally charges UserTick for every user instruction,
+//	however it uses memory.  When started with "-icache <bytes>" or
+//	"-dcache <bytes>", the simulator models an instruction or data
+//	cache in front of mainMemory, and charges each miss as extra user
+//	ticks, so that the effect of a program's memory layout shows up
+//	in its running time.  "-cacheways", "-cacheline" and
+//	"-misspenalty" set the shape of the caches and the cost of a miss.
+//	The hits and misses are counted in Statistics.
+//
+//	Only the tags are modeled: data still lives in mainMemory, so the
+//	caches never hold anything stale.  Caches are indexed by physical
+//	address, allocate a line on every miss, reads or writes, and
+//	replace the least recently used line of a set.  Writing back dirty
+//	lines is taken to be free.
+//
+//	Caches are modeled by the instruction-at-a-time simulator; the
+//	block engine (-bb) is turned off while they are on.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// The following class defines one set-associative cache.
+
+class Cache {
+  public:
+    Cache(int size, int ways, int lineSize, int missPenalty);
+				// an empty cache of "size" bytes, in sets
+				// of "ways" lines of "lineSize" bytes each
+    ~Cache();
+
+    bool Access(int physAddr);	// reference the line holding "physAddr";
+				// return TRUE if it was in the cache
+
+    int MissPenalty() { return missPenalty; }
+				// ticks to charge for a miss
+
+  private:
+    int *tags;			// the line number held by each line of
+				// each set, or -1
+    unsigned int *usedAt;	// when each line was last used
+    unsigned int accesses;	// the clock for usedAt
+    int numSets;
+    int ways;			// lines per set
+    int lineShift;		// log2 of the line size
+    int missPenalty;
+};
+
+#endif // CACHE_H
@@ -37,7 +37,8 @@ ConsoleInput::ConsoleInput(char *readFile, CallBackObj *toCall)
     incoming = EOF;
 
     // start polling for incoming keystrokes
-    kernel->interrupt->Schedule(this, ConsoleTime, ConsoleReadInt);
+    kernel->interrupt->Schedule(this, ConsoleTime, ConsoleReadInt,
+				readFileNo);
 }
 
 //----------------------------------------------------------------------
@@ -70,7 +71,8 @@ ConsoleInput::CallBack()
     ASSERT(incoming == EOF);
     if (!PollFile(readFileNo)) { // nothing to be read
         // schedule the next time to poll for a packet
-        kernel->interrupt->Schedule(this, ConsoleTime, ConsoleReadInt);
+        kernel->interrupt->Schedule(this, ConsoleTime, ConsoleReadInt,
+				    readFileNo);
     } else { 
     	// otherwise, try to read a character
     	readCount = ReadPartial(readFileNo, &c, sizeof(char));
@@ -104,7 +106,8 @@ ConsoleInput::GetChar()
    char ch = incoming;
 
    if (incoming != EOF) {	// schedule when next char will arrive
-       kernel->interrupt->Schedule(this, ConsoleTime, ConsoleReadInt);
+       kernel->interrupt->Schedule(this, ConsoleTime, ConsoleReadInt,
+				   readFileNo);
    }
    incoming = EOF;
    return ch;
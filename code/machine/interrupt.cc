@@ -23,6 +23,9 @@
 #include "copyright.h"
 #include "interrupt.h"
 #include "main.h"
+#include "profile.h"
+#include "pool.h"
+#include <limits.h>
 
 // String definitions for debugging messages
 
@@ -39,14 +42,44 @@ static char *intTypeNames[] = {"timer", "disk", "console write",
 //	"callOnInt" is the object to call when the interrupt occurs
 //	"time" is when (in simulated time) the interrupt is to occur
 //	"kind" is the hardware device that generated the interrupt
+//	"file" is the host file the device will poll for input when the
+//		interrupt occurs, or -1
 //----------------------------------------------------------------------
 
 PendingInterrupt::PendingInterrupt(CallBackObj *callOnInt,
-                                   int time, IntType kind)
+                                   int time, IntType kind, int file)
 {
     callOnInterrupt = callOnInt;
     when = time;
     type = kind;
+    pollFile = file;
+    heapIndex = -1;
+}
+
+//----------------------------------------------------------------------
+// PendingInterrupt::operator new, operator delete
+// 	Interrupts are scheduled, and deleted once they have occurred,
+//	over and over, so PendingInterrupts are kept in a Pool of
+//	their own (made the first time one is needed), rather than being
+//	allocated by the host each time.
+//----------------------------------------------------------------------
+
+static Pool *pendingPool = NULL;
+
+void *
+PendingInterrupt::operator new(size_t size)
+{
+    ASSERT(size == sizeof(PendingInterrupt));
+    if (pendingPool == NULL)
+    {
+        pendingPool = new Pool("interrupts", sizeof(PendingInterrupt));
+    }
+    return pendingPool->Alloc();
+}
+
+void PendingInterrupt::operator delete(void *object)
+{
+    pendingPool->Free(object);
 }
 
 //----------------------------------------------------------------------
@@ -71,20 +104,42 @@ PendingCompare(PendingInterrupt *x, PendingInterrupt *y)
     }
 }
 
+//----------------------------------------------------------------------
+// PendingMoved
+//	Record where an interrupt is in the heap of pending interrupts,
+//	so that it can be cancelled without searching for it.
+//----------------------------------------------------------------------
+
+static void
+PendingMoved(PendingInterrupt *x, int i)
+{
+    x->heapIndex = i;
+}
+
 //----------------------------------------------------------------------
 // Interrupt::Interrupt
 // 	Initialize the simulation of hardware device interrupts.
 //
 //	Interrupts start disabled, with no interrupts pending, etc.
+//
+//	The pending interrupts are kept in a heap, so that scheduling one,
+//	taking the next one out, or cancelling one take O(log n) steps
+//	however many are pending, and nextDue caches when the earliest of
+//	them is due, so that most ticks only have to compare it with the
+//	clock.
 //----------------------------------------------------------------------
 
 Interrupt::Interrupt()
 {
     level = IntOff;
-    pending = new SortedList<PendingInterrupt *>(PendingCompare);
+    pending = new Heap<PendingInterrupt *>(PendingCompare, PendingMoved);
+    nextDue = INT_MAX;
     inHandler = FALSE;
     yieldOnReturn = FALSE;
     status = SystemMode;
+    tickless = FALSE;
+    usecPerTick = 0;
+    startTime = 0;
 }
 
 //----------------------------------------------------------------------
@@ -172,12 +227,16 @@ void Interrupt::OneTick()
     }
     DEBUG(dbgInt, "== Tick " << stats->totalTicks << " ==");
 
-    // check any pending interrupts are now ready to fire
-    ChangeLevel(IntOn, IntOff); // first, turn off interrupts
-                                // (interrupt handlers run with
-                                // interrupts disabled)
-    CheckIfDue(FALSE);          // check for pending interrupts
-    ChangeLevel(IntOff, IntOn); // re-enable interrupts
+    // check any pending interrupts are now ready to fire; usually
+    // none is, and there is no need to look (unless debugging)
+    if (stats->totalTicks >= nextDue || debug->IsEnabled(dbgInt))
+    {
+        ChangeLevel(IntOn, IntOff); // first, turn off interrupts
+                                    // (interrupt handlers run with
+                                    // interrupts disabled)
+        CheckIfDue(FALSE);          // check for pending interrupts
+        ChangeLevel(IntOff, IntOn); // re-enable interrupts
+    }
     if (yieldOnReturn)
     {   // if the timer device handler asked
         // for a context switch, ok to do it now
@@ -188,6 +247,61 @@ void Interrupt::OneTick()
     }
 }
 
+//----------------------------------------------------------------------
+// Interrupt::QuietTicks
+// 	Return how many ticks of simulated time can pass before the next
+//	pending interrupt is due.  Over that stretch, calling OneTick()
+//	on every tick would find nothing to do, so the simulator may
+//	advance the clock in one step with AdvanceQuietly() instead.
+//
+//	If a context switch has been requested (for instance by an
+//	interrupt handled while the machine was idle), it must happen
+//	on the very next tick, so there is no quiet time at all.
+//----------------------------------------------------------------------
+
+int Interrupt::QuietTicks()
+{
+    int ticks;
+
+    if (yieldOnReturn)
+    {
+        return 0;
+    }
+    if (nextDue == INT_MAX)
+    {
+        return INT_MAX;
+    }
+    ticks = nextDue - kernel->stats->totalTicks - 1;
+    return (ticks > 0) ? ticks : 0;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::AdvanceQuietly
+// 	Advance simulated time by "ticks" in one step, charging them the
+//	same way OneTick() would, but without checking for interrupts.
+//	The caller must make sure that "ticks" is no more than
+//	QuietTicks(), so that the result is the same as calling OneTick()
+//	once per tick.
+//
+//	"ticks" -- how far to advance simulated time
+//----------------------------------------------------------------------
+
+void Interrupt::AdvanceQuietly(int ticks)
+{
+    Statistics *stats = kernel->stats;
+
+    ASSERT(ticks <= QuietTicks());
+    stats->totalTicks += ticks;
+    if (status == SystemMode)
+    {
+        stats->systemTicks += ticks;
+    }
+    else
+    {
+        stats->userTicks += ticks;
+    }
+}
+
 //----------------------------------------------------------------------
 // Interrupt::YieldOnReturn
 // 	Called from within an interrupt handler, to cause a context switch
@@ -220,7 +334,7 @@ void Interrupt::Idle()
 {
     DEBUG(dbgInt, "Machine idling; checking for interrupts.");
     status = IdleMode;
-    if (CheckIfDue(TRUE))
+    if ((!tickless || WaitForHost()) && CheckIfDue(TRUE))
     { // check for any pending interrupts
         status = SystemMode;
         return; // return in case there's now
@@ -238,6 +352,91 @@ void Interrupt::Idle()
     Halt();
 }
 
+//----------------------------------------------------------------------
+// Interrupt::SetTickless
+// 	Stop polling for input while the machine is idle; instead, wait
+//	for it on the host (see WaitForHost).  This is for interactive
+//	use of the console and the network: otherwise an idle Nachos keeps
+//	the host CPU busy, rolling simulated time forward from one poll
+//	to the next.
+//
+//	"usecPerTick" -- if not 0, also keep simulated time from running
+//		ahead of the host's time, at this many microseconds a tick
+//----------------------------------------------------------------------
+
+void Interrupt::SetTickless(int usecPerTick)
+{
+    ASSERT(usecPerTick >= 0);
+    tickless = TRUE;
+    this->usecPerTick = usecPerTick;
+    startTime = HostTime() - kernel->stats->totalTicks * (usecPerTick / 1e6);
+}
+
+//----------------------------------------------------------------------
+// Interrupt::WaitForHost
+// 	Called when the machine is idle, in tickless mode, before rolling
+//	simulated time forward to the next interrupt.  If the only
+//	interrupts pending are polls for input from the host and timer
+//	interrupts (which do nothing for an idle machine), nothing can
+//	happen until some input arrives, so put the host to sleep until
+//	it does, rather than running the polls over and over.  The
+//	exception is when the scheduler will make a thread ready on a
+//	timer interrupt (see Scheduler::NextRelease); that matters as
+//	much as any other interrupt.
+//
+//	If something else is pending, such as a disk request, it happens
+//	at once -- unless simulated time is being paced, in which case
+//	wait (or watch for input) until the host's time catches up with
+//	it.
+//
+// Returns:
+//	FALSE, if nothing but timer interrupts is pending, so that
+//	nothing can ever happen
+//----------------------------------------------------------------------
+
+bool Interrupt::WaitForHost()
+{
+    int *files = new int[pending->NumInHeap() + 1];
+    int numFiles = 0;
+    int due = kernel->scheduler->NextRelease();
+                       // when the next interrupt that matters is
+    int msec = 0;      // how long to wait for it
+    PendingInterrupt *toOccur;
+
+    for (int i = 0; i < pending->NumInHeap(); i++)
+    {
+        toOccur = pending->Item(i);
+        if (toOccur->pollFile >= 0)
+        {
+            files[numFiles++] = toOccur->pollFile;
+        }
+        else if (toOccur->type != TimerInt && toOccur->when < due)
+        {
+            due = toOccur->when;
+        }
+    }
+
+    if (due == INT_MAX)
+    {
+        msec = (numFiles > 0) ? -1 : 0; // wait for input, if any can come
+    }
+    else if (usecPerTick > 0)
+    {
+        msec = (int)((startTime + due * (usecPerTick / 1e6) - HostTime()) * 1000);
+        if (msec < 0)
+        { // simulated time is already behind
+            msec = 0;
+        }
+    }
+    if (msec != 0)
+    {
+        DEBUG(dbgInt, "Waiting on the host for " << numFiles << " files, " << msec << " msec");
+        WaitForFiles(files, numFiles, msec);
+    }
+    delete[] files;
+    return due != INT_MAX || numFiles > 0;
+}
+
 //----------------------------------------------------------------------
 // Interrupt::Halt
 // 	Shut down Nachos cleanly, printing out performance statistics.
@@ -246,6 +445,10 @@ void Interrupt::Halt()
 {
     cout << "Machine halting!\n\n";
     kernel->stats->Print();
+    if (kernel->profile != NULL)
+        kernel->profile->Print();
+    if (kernel->poolStats)
+        PrintPools(kernel->stats->totalTicks);
     delete kernel; // Never returns.
 }
 
@@ -254,25 +457,68 @@ void Interrupt::Halt()
 // 	Arrange for the CPU to be interrupted when simulated time
 //	reaches "now + when".
 //
-//	Implementation: just put it on a sorted list.
+//	Implementation: put it in the heap of pending interrupts.
 //
 //	NOTE: the Nachos kernel should not call this routine directly.
 //	Instead, it is only called by the hardware device simulators.
 //
+// Returns:
+//	The scheduled interrupt, which may be passed to Cancel until
+//	it occurs.
+// Params:
 //	"toCall" is the object to call when the interrupt occurs
 //	"fromNow" is how far in the future (in simulated time) the
 //		 interrupt is to occur
 //	"type" is the hardware device that generated the interrupt
+//	"pollFile" is the host file the device will poll for input when
+//		the interrupt occurs, if it's that kind of interrupt
+//		(see WaitForHost); otherwise -1
 //----------------------------------------------------------------------
-void Interrupt::Schedule(CallBackObj *toCall, int fromNow, IntType type)
+PendingInterrupt *
+Interrupt::Schedule(CallBackObj *toCall, int fromNow, IntType type,
+                    int pollFile)
 {
     int when = kernel->stats->totalTicks + fromNow;
-    PendingInterrupt *toOccur = new PendingInterrupt(toCall, when, type);
+    PendingInterrupt *toOccur = new PendingInterrupt(toCall, when, type,
+                                                     pollFile);
 
     DEBUG(dbgInt, "Scheduling interrupt handler the " << intTypeNames[type] << " at time = " << when);
     ASSERT(fromNow > 0);
 
     pending->Insert(toOccur);
+    if (when < nextDue)
+    {
+        nextDue = when;
+    }
+    return toOccur;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::Cancel
+// 	Take back an interrupt that was scheduled, so that it never
+//	occurs.  It must not have occurred yet, nor already have been
+//	cancelled, since by then it has been deleted.
+//
+//	"toCancel" is the interrupt, as returned by Schedule
+//----------------------------------------------------------------------
+void Interrupt::Cancel(PendingInterrupt *toCancel)
+{
+    DEBUG(dbgInt, "Cancelling interrupt handler the " << intTypeNames[toCancel->type] << " at time = " << toCancel->when);
+
+    ASSERT(toCancel->heapIndex >= 0); // still pending
+    pending->RemoveAt(toCancel->heapIndex);
+    delete toCancel;
+    UpdateNextDue();
+}
+
+//----------------------------------------------------------------------
+// Interrupt::UpdateNextDue
+// 	Recompute when the next pending interrupt is due, after some have
+//	been taken out of the heap.
+//----------------------------------------------------------------------
+void Interrupt::UpdateNextDue()
+{
+    nextDue = pending->IsEmpty() ? INT_MAX : pending->Front()->when;
 }
 
 //----------------------------------------------------------------------
@@ -298,12 +544,12 @@ bool Interrupt::CheckIfDue(bool advanceClock)
     {
         DumpState();
     }
-    if (pending->IsEmpty())
+    if (nextDue == INT_MAX)
     { // no pending interrupts
         return FALSE;
     }
     next = pending->Front();
-    if (next->when > stats->totalTicks)
+    if (nextDue > stats->totalTicks)
     {
         if (!advanceClock)
         { // not time yet
@@ -311,8 +557,8 @@ bool Interrupt::CheckIfDue(bool advanceClock)
         }
         else
         { // advance the clock to next interrupt
-            stats->idleTicks += (next->when - stats->totalTicks);
-            stats->totalTicks = next->when;
+            stats->idleTicks += (nextDue - stats->totalTicks);
+            stats->totalTicks = nextDue;
             // UDelay(1000L); // rcgood - to stop nachos from spinning.
         }
     }
@@ -328,11 +574,17 @@ bool Interrupt::CheckIfDue(bool advanceClock)
     inHandler = TRUE;
     do
     {
-        next = pending->RemoveFront();     // pull interrupt off list
+        next = pending->RemoveFront();     // pull interrupt off heap
+        UpdateNextDue();
         next->callOnInterrupt->CallBack(); // call the interrupt handler
         delete next;
-    } while (!pending->IsEmpty() && (pending->Front()->when <= stats->totalTicks));
+    } while (nextDue <= stats->totalTicks);
     inHandler = FALSE;
+
+    if (kernel->machine != NULL)
+    { // the handlers may have changed the page tables
+        kernel->machine->FlushSoftTLB();
+    }
     return TRUE;
 }
 
@@ -363,3 +615,71 @@ void Interrupt::DumpState()
     pending->Apply(PrintPending);
     cout << "\nEnd of pending interrupts\n";
 }
+
+//----------------------------------------------------------------------
+// Interrupt::WriteSnapshot
+// 	Save the kind of each pending interrupt, and when it is due, to
+//	a snapshot file.  The objects to call can't be saved, since they
+//	only exist in this run of Nachos.
+//
+//	"fd" -- the snapshot file
+//----------------------------------------------------------------------
+
+void Interrupt::WriteSnapshot(int fd)
+{
+    List<PendingInterrupt *> *inOrder = new List<PendingInterrupt *>;
+    int numPending = pending->NumInHeap();
+    int entry[2];
+
+    WriteFile(fd, (char *)&numPending, sizeof(int));
+    while (!pending->IsEmpty())
+        inOrder->Append(pending->RemoveFront());
+    while (!inOrder->IsEmpty())
+    {
+        entry[0] = inOrder->Front()->type;
+        entry[1] = inOrder->Front()->when;
+        WriteFile(fd, (char *)entry, sizeof(entry));
+        pending->Insert(inOrder->RemoveFront()); // put it back
+    }
+    delete inOrder;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::ReadSnapshot
+// 	Restore the times of the pending interrupts from a snapshot file.
+//	The devices of this run of Nachos have already scheduled their
+//	own interrupts; each of these is moved to the time of a saved
+//	interrupt of the same kind, if there is one.
+//
+//	"fd" -- the snapshot file
+//----------------------------------------------------------------------
+
+void Interrupt::ReadSnapshot(int fd)
+{
+    List<PendingInterrupt *> *unsorted = new List<PendingInterrupt *>;
+    PendingInterrupt *toOccur;
+    int numSaved;
+    int(*saved)[2];
+
+    Read(fd, (char *)&numSaved, sizeof(int));
+    saved = new int[numSaved][2];
+    Read(fd, (char *)saved, numSaved * sizeof(saved[0]));
+
+    while (!pending->IsEmpty())
+        unsorted->Append(pending->RemoveFront());
+    while (!unsorted->IsEmpty())
+    {
+        toOccur = unsorted->RemoveFront();
+        for (int i = 0; i < numSaved; i++)
+            if (saved[i][0] == toOccur->type)
+            {
+                toOccur->when = saved[i][1];
+                saved[i][0] = -1; // used up
+                break;
+            }
+        pending->Insert(toOccur); // re-sort by the new times
+    }
+    UpdateNextDue();
+    delete unsorted;
+    delete[] saved;
+}
@@ -35,6 +35,7 @@
 
 #include "copyright.h"
 #include "list.h"
+#include "heap.h"
 #include "callback.h"
 
 // Interrupts can be disabled (IntOff) or enabled (IntOn)
@@ -57,7 +58,8 @@ enum IntType { TimerInt, DiskInt, ConsoleWriteInt, ConsoleReadInt,
 
 class PendingInterrupt {
   public:
-    PendingInterrupt(CallBackObj *callOnInt, int time, IntType kind);
+    PendingInterrupt(CallBackObj *callOnInt, int time, IntType kind,
+		     int file);
 				// initialize an interrupt that will
 				// occur in the future
 
@@ -66,6 +68,13 @@ class PendingInterrupt {
     
     int when;			// When the interrupt is supposed to fire
     IntType type;		// for debugging
+    int pollFile;		// the host file the handler will poll
+				// for input, or -1
+    int heapIndex;		// where it is in the heap of pending
+				// interrupts, or -1 once taken out
+
+    void *operator new(size_t size);	// allocate from a Pool of
+    void operator delete(void *object);	// PendingInterrupts
 };
 
 // The following class defines the data structures for the simulation
@@ -91,6 +100,10 @@ class Interrupt {
     void Idle(); 		// The ready queue is empty, roll 
 				// simulated time forward until the 
 				// next interrupt
+    void SetTickless(int usecPerTick);
+    				// From now on, wait on the host when
+				// idle, instead of polling for input
+				// (see Interrupt::WaitForHost)
 
     void Halt(); 		// quit and print out stats
     
@@ -102,6 +115,10 @@ class Interrupt {
         			// idle, kernel, user
 
     void DumpState();		// Print interrupt state
+
+    void WriteSnapshot(int fd);	// Save or restore when each kind of
+    void ReadSnapshot(int fd);	// interrupt is next due (see
+				// Kernel::SaveSnapshot)
     
 
     // NOTE: the following are internal to the hardware simulation code.
@@ -109,22 +126,41 @@ class Interrupt {
     // but they need to be public since they are called by the
     // hardware device simulators.
 
-    void Schedule(CallBackObj *callTo, int when, IntType type);
+    PendingInterrupt *Schedule(CallBackObj *callTo, int when,
+				IntType type, int pollFile = -1);
     				// Schedule an interrupt to occur
 				// at time "when".  This is called
-    				// by the hardware device simulators.
+    				// by the hardware device simulators;
+				// those that poll a host file for
+				// input say which one.
+    void Cancel(PendingInterrupt *toCancel);
+    				// Take back a scheduled interrupt
+				// that has not yet occurred
     
     void OneTick();       	// Advance simulated time
 
+    int QuietTicks();		// How far simulated time can advance
+				// before an interrupt could be due
+    void AdvanceQuietly(int ticks);
+    				// Advance simulated time by "ticks",
+				// which must be within QuietTicks()
+
   private:
     IntStatus level;		// are interrupts enabled or disabled?
-    SortedList<PendingInterrupt *> *pending;		
-    				// the list of interrupts scheduled
-				// to occur in the future
+    Heap<PendingInterrupt *> *pending;
+    				// the interrupts scheduled to occur
+				// in the future, earliest first
+    int nextDue;		// when the earliest of them is due,
+				// or INT_MAX if there are none
     bool inHandler;		// TRUE if we are running an interrupt handler
     bool yieldOnReturn; 	// TRUE if we are to context switch
 				// on return from the interrupt handler
     MachineStatus status;	// idle, kernel mode, user mode
+    bool tickless;		// wait on the host when idle?
+    int usecPerTick;		// if so, the host microseconds each
+				// tick should take, or 0 not to pace
+				// simulated time
+    double startTime;		// host time at tick 0, for pacing
 
     // these functions are internal to the interrupt simulation code
 
@@ -134,6 +170,11 @@ class Interrupt {
 
     void ChangeLevel(IntStatus old, 	// SetLevel, without advancing the
 			IntStatus now); // simulated time
+
+    void UpdateNextDue();	// recompute nextDue
+
+    bool WaitForHost();		// when idle, wait until there is
+				// something to do
 };
 
 #endif // INTERRRUPT_H
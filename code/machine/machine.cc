@@ -9,7 +9,19 @@
 
 #include "copyright.h"
 #include "machine.h"
+#include "cache.h"
+#include "timing.h"
+#include "native.h"
 #include "main.h"
+#include <limits.h>
+
+// The size of the simulated machine; see machine.h
+int PageSize = 128;
+int PageShift = 7;
+int NumPhysPages = 128;
+int MemorySize = 128 * 128;
+int TLBSize = 4;
+int TLBWays = 4;
 
 // Textual names of the exceptions that can be generated by user program
 // execution, for debugging.
@@ -44,15 +56,48 @@ static void CheckEndian()
 #endif
 }
 
+//----------------------------------------------------------------------
+// SetMachineGeometry
+// 	Set the size of the machine to be simulated.  Called before the
+//	Machine is created, since everything it allocates depends on it.
+//
+//	"pageSize" -- bytes per page; a power of 2, at least a word
+//	"numPhysPages" -- pages of physical memory
+//	"tlbSize" -- entries in the TLB, if there is one
+//	"tlbWays" -- entries in each set of the TLB; 0 makes it fully
+//		associative
+//----------------------------------------------------------------------
+
+void SetMachineGeometry(int pageSize, int numPhysPages, int tlbSize,
+                        int tlbWays)
+{
+    if (tlbWays == 0)
+        tlbWays = tlbSize;
+    ASSERT(pageSize >= 4 && (pageSize & (pageSize - 1)) == 0);
+    ASSERT(numPhysPages > 0 && tlbSize > 0);
+    ASSERT(tlbWays > 0 && tlbSize % tlbWays == 0);
+    ASSERT(numPhysPages <= INT_MAX / pageSize);
+
+    PageSize = pageSize;
+    for (PageShift = 0; (1 << PageShift) < pageSize; PageShift++)
+        ;
+    NumPhysPages = numPhysPages;
+    MemorySize = numPhysPages * pageSize;
+    TLBSize = tlbSize;
+    TLBWays = tlbWays;
+}
+
 //----------------------------------------------------------------------
 // Machine::Machine
 // 	Initialize the simulation of user program execution.
 //
 //	"debug" -- if TRUE, drop into the debugger after each user instruction
 //		is executed.
+//	"blocks" -- if TRUE, run user programs with the block engine
+//		rather than one instruction at a time.
 //----------------------------------------------------------------------
 
-Machine::Machine(bool debug)
+Machine::Machine(bool debug, bool blocks)
 {
     int i;
 
@@ -61,16 +106,32 @@ Machine::Machine(bool debug)
     mainMemory = new char[MemorySize];
     for (i = 0; i < MemorySize; i++)
         mainMemory[i] = 0;
+    decodeCache = new DecodedPage *[NumPhysPages];
+    for (i = 0; i < NumPhysPages; i++)
+        decodeCache[i] = NULL;
+    for (i = 0; i < SoftTLBSize; i++)
+        softTLB[i].generation = 0;
+    softTLBGeneration = 1;
+    runningQuietly = FALSE;
+    quietInstrs = 0;
+    useBlocks = blocks;
+    retiredBlocks = new List<TranslatedBlock *>;
+    blocksRetired = FALSE;
+    blockOp = NULL;
+    blockTarget = 0;
 #ifdef USE_TLB
-    tlb = new TranslationEntry[TLBSize];
-    for (i = 0; i < TLBSize; i++)
-        tlb[i].valid = FALSE;
+    tlb = new TLB(TLBSize, TLBWays);
     pageTable = NULL;
  
 #else // use linear page table
     tlb = NULL;
     pageTable = NULL;
 #endif
+    spaceId = 0;
+    iCache = dCache = NULL;
+    timing = NULL;
+    nativeCode = NULL;
+    stallTicks = 0;
 
     singleStep = debug;
     CheckEndian();
@@ -83,9 +144,15 @@ Machine::Machine(bool debug)
 
 Machine::~Machine()
 {
+    DeleteDecodeCache();
+    delete retiredBlocks;
     delete[] mainMemory;
     if (tlb != NULL)
-        delete[] tlb;
+        delete tlb;
+    delete iCache;
+    delete dCache;
+    delete timing;
+    delete nativeCode;
 }
 
 //----------------------------------------------------------------------
@@ -102,14 +169,54 @@ void Machine::RaiseException(ExceptionType which, int badVAddr)
 {
     DEBUG(dbgMach, "Exception: " << exceptionNames[which]);
 
+    LeaveBlock(); // if we trapped out of a translated block
+    if (runningQuietly)
+    { // charge for the instructions run since the last tick
+        runningQuietly = FALSE;
+        kernel->interrupt->AdvanceQuietly(quietInstrs * UserTick);
+    }
     registers[BadVAddrReg] = badVAddr;
     DelayedLoad(0, 0); // finish anything in progress
     kernel->interrupt->setStatus(SystemMode);
 
     ExceptionHandler(which); // interrupts are enabled at this point
+    FlushSoftTLB();          // the kernel may have changed the mappings
     kernel->interrupt->setStatus(UserMode);
 }
 
+//----------------------------------------------------------------------
+// Machine::WriteSnapshot
+// 	Save the CPU registers, and the TLB if there is one, to a
+//	snapshot file.  Main memory is saved by the address spaces that
+//	use it.
+//
+//	"fd" -- the snapshot file
+//----------------------------------------------------------------------
+
+void Machine::WriteSnapshot(int fd)
+{
+    WriteFile(fd, (char *)registers, sizeof(registers));
+    if (tlb != NULL)
+        tlb->WriteSnapshot(fd);
+}
+
+//----------------------------------------------------------------------
+// Machine::ReadSnapshot
+// 	Restore the CPU registers and the TLB from a snapshot file.
+//	The caller has checked that the snapshot was taken on a machine
+//	like this one.
+//
+//	"fd" -- the snapshot file
+//----------------------------------------------------------------------
+
+void Machine::ReadSnapshot(int fd)
+{
+    Read(fd, (char *)registers, sizeof(registers));
+    if (tlb != NULL)
+        tlb->ReadSnapshot(fd);
+    FlushSoftTLB();
+}
+
 //----------------------------------------------------------------------
 // Machine::Debugger
 // 	Primitive debugger for user programs.  Note that we can't use
@@ -23,22 +23,30 @@
 
 #include "copyright.h"
 #include "utility.h"
+#include "list.h"
 #include "translate.h"
 
 // Definitions related to the size, and format of user memory
-
-const int PageSize = 128; 		// set the page size equal to
-					// the disk sector size, for simplicity
-
 //
-// You are allowed to change this value.
-// Doing so will change the number of pages of physical memory
-// available on the simulated machine.
-//
-const int NumPhysPages = 128;
-
-const int MemorySize = (NumPhysPages * PageSize);
-const int TLBSize = 4;			// if there is a TLB, make it small
+// These are chosen when Nachos starts up (see SetMachineGeometry, and
+// the -ps, -pp, -tlb and -tlbways flags in Kernel::Kernel), and must
+// not change once the Machine has been created.  By default the page
+// size is equal to the disk sector size, for simplicity, and there are
+// 128 pages of physical memory and a 4-entry, fully associative TLB.
+
+extern int PageSize;			// bytes per page; a power of 2
+extern int PageShift;			// log2(PageSize)
+extern int NumPhysPages;		// pages of physical memory
+extern int MemorySize;			// NumPhysPages * PageSize
+extern int TLBSize;			// if there is a TLB, make it small
+extern int TLBWays;			// TLB entries per set
+
+extern void SetMachineGeometry(int pageSize, int numPhysPages, int tlbSize,
+			       int tlbWays);
+					// Change the values above
+
+const int SoftTLBSize = 64;		// translations cached by the simulator
+					// itself (not part of the hardware)
 
 enum ExceptionType { NoException,           // Everything ok!
 		     SyscallException,      // A program executed a system call.
@@ -75,6 +83,21 @@ enum ExceptionType { NoException,           // Everything ok!
 
 #define NumTotalRegs 	40
 
+// The following class defines an entry of the soft TLB: a cache, private
+// to the simulator, of recent translations (see translate.cc).  It
+// lets loads and stores skip Translate without changing anything the
+// user program or the kernel can see.
+
+class SoftTLBEntry {
+  public:
+    unsigned int virtualPage;	// the page this entry translates
+    unsigned int generation;	// entry is valid only if this equals
+				// Machine::softTLBGeneration
+    char *host;			// where the page is in mainMemory
+    bool writable;		// can be written without a trap
+    TranslationEntry *entry;	// the page table or TLB entry it came from
+};
+
 // The following class defines the simulated host workstation hardware, as 
 // seen by user programs -- the CPU registers, main memory, etc.
 // User programs shouldn't be able to tell that they are running on our 
@@ -89,12 +112,21 @@ enum ExceptionType { NoException,           // Everything ok!
 // translate.cc.
 
 class Instruction;
+class DecodedPage;
+class TranslatedBlock;
+class BlockOp;
+class Cache;
+class TimingModel;
+class NativeCode;
+struct NativeContext;
 class Interrupt;
 
 class Machine {
   public:
-    Machine(bool debug);	// Initialize the simulation of the hardware
-				// for running user programs
+    Machine(bool debug, bool blocks);
+				// Initialize the simulation of the hardware
+				// for running user programs; if "blocks",
+				// run them with the block engine
     ~Machine();			// De-allocate the data structures
 
 // Routines callable by the Nachos kernel
@@ -125,6 +157,8 @@ class Machine {
 // If "tlb" is non-NULL, the Nachos kernel is responsible for managing
 //	the contents of the TLB.  But the kernel can use any data structure
 //	it wants (eg, segmented paging) for handling TLB cache misses.
+//	The TLB only matches entries tagged with "spaceId", which the
+//	kernel sets when it switches address spaces.
 // 
 // For simplicity, both the page table pointer and the TLB pointer are
 // public.  However, while there can be multiple page tables (one per address
@@ -132,26 +166,108 @@ class Machine {
 // Thus the TLB pointer should be considered as *read-only*, although 
 // the contents of the TLB are free to be modified by the kernel software.
 
-    TranslationEntry *tlb;		// this pointer should be considered 
+    TLB *tlb;				// this pointer should be considered 
 					// "read-only" to Nachos kernel code
+    int spaceId;			// ASID of the address space running
 
     TranslationEntry *pageTable;
     unsigned int pageTableSize;
 
+    Cache *iCache;			// the instruction and data caches,
+    Cache *dCache;			// or NULL if they aren't simulated
+					// (see cache.h); deleted with us
+    TimingModel *timing;		// the cost of each instruction, or
+					// NULL if they all take UserTick
+					// (see timing.h); deleted with us
+    NativeCode *nativeCode;		// blocks compiled ahead of time, for
+					// the block engine to use, or NULL
+					// (see native.h); deleted with us
+
     bool ReadMem(int addr, int size, int* value);
     bool WriteMem(int addr, int size, int value);
     				// Read or write 1, 2, or 4 bytes of virtual 
 				// memory (at addr).  Return FALSE if a 
 				// correct translation couldn't be found.
+
+    int CopyIn(int virtAddr, char *into, int count);
+    int CopyOut(int virtAddr, char *from, int count);
+				// Copy "count" bytes between user memory
+				// (at virtAddr) and a kernel buffer, a page
+				// at a time.  Return the number of bytes
+				// copied.
+    int StringIn(int virtAddr, char *into, int size);
+				// Copy a null-terminated string from user
+				// memory.  Return its length, or -1 if
+				// it couldn't all be translated.
+
+    void FlushDecodeCache();	// Forget all pre-decoded instructions.
+				// Must be called whenever the kernel
+				// writes code into mainMemory directly,
+				// rather than through WriteMem.
+
+    void WriteSnapshot(int fd);	// Save or restore the registers and
+    void ReadSnapshot(int fd);	// the TLB (see Kernel::SaveSnapshot)
+
+    void FlushSoftTLB();	// Forget all cached translations.
+				// Must be called whenever the kernel
+				// changes the page table or the TLB,
+				// outside of an exception handler.
   private:
 
 // Routines internal to the machine simulation -- DO NOT call these directly
     void DelayedLoad(int nextReg, int nextVal);  	
 				// Do a pending delayed load (modifying a reg)
 
-    void OneInstruction(Instruction *instr); 	
-    				// Run one instruction of a user program.
-    
+    template <class Policy> void Interpret();
+				// The body of Run: simulate forever,
+				// checking only for what "Policy"
+				// says might be on (see mipssim.h)
+
+    template <class Policy> void OneInstruction();
+				// Run one instruction of a user program.
+
+    void ExecuteWatched(Instruction *instr);
+				// Run an instruction that is being
+				// profiled or timed.
+
+    template <class Policy> void ExecuteInstruction(Instruction *instr);
+				// Run an instruction that has already
+				// been fetched from the current PC.
+
+    template <class Policy> Instruction *FetchInstruction();
+				// Translate the PC and return the decoded
+				// instruction there, decoding it only if
+				// it isn't already in the decode cache.
+				// Return NULL if the fetch trapped.
+
+    Instruction *DecodeWord(int physAddr);
+				// Return the decoded instruction at
+				// physAddr, decoding it if need be.
+
+    void InvalidateCode(int physAddr);
+				// The word at physAddr has been written;
+				// drop any decoded copy of it.
+    void DeleteDecodeCache();	// De-allocate the decode cache
+
+// The block engine, in blocksim.cc
+    void RunBlocks();		// Run() using translated basic blocks
+    TranslatedBlock *FindBlock(int virtAddr);
+				// Find (or translate) the block at virtAddr
+    TranslatedBlock *TranslateBlock(int virtAddr, int physAddr);
+				// Translate the block at virtAddr
+    void ExecuteBlock(TranslatedBlock *block);
+				// Run a block from beginning to end
+    void LeaveBlock();		// Bring the registers and the clock up to
+				// date, when a block traps to the kernel
+    void ExecuteNative(TranslatedBlock *block);
+				// Run a block's compiled code instead
+    static int NativeStep(NativeContext *context, int index);
+				// Run one instruction of it for it
+
+    void RetireBlocks(DecodedPage *page, int index);
+				// Stop using the blocks covering a word
+				// (or all words, if index is -1)
+    void FreeRetiredBlocks();	// De-allocate retired blocks
 
 
     ExceptionType Translate(int virtAddr, int* physAddr, int size,bool writing);
@@ -161,6 +277,24 @@ class Machine {
     				// and return an exception code if the 
 				// translation couldn't be completed.
 
+    char *QuickTranslate(int virtAddr, int size, bool writing);
+				// Translate an address using the soft
+				// TLB; return NULL if it isn't there.
+    void FillSoftTLB(int virtAddr);
+				// Remember a successful translation
+    char *UserPage(int virtAddr, bool writing);
+				// Translate an address for CopyIn and
+				// friends, handling page faults
+
+    void UseCache(Cache *cache, int physAddr, int *hits, int *misses);
+				// Look up an address in a cache, counting
+				// the hit or miss, and the stall if any
+    void Stall();		// Charge for the stall, one tick at a time
+    bool MayStall() { return iCache != NULL || dCache != NULL ||
+			     timing != NULL; }
+				// Can an instruction take more than
+				// UserTick?
+
     void RaiseException(ExceptionType which, int badVAddr);
 				// Trap to the Nachos kernel, because of a
 				// system call or other exception.  
@@ -173,6 +307,33 @@ class Machine {
 
     int registers[NumTotalRegs]; // CPU registers, for executing user programs
 
+    DecodedPage **decodeCache;	// decoded instructions, one entry per
+				// physical page (NULL until we first
+				// fetch an instruction from the page)
+
+    SoftTLBEntry softTLB[SoftTLBSize];
+    unsigned int softTLBGeneration;
+				// bumped to flush the soft TLB
+
+    bool runningQuietly;	// are we running instructions without
+				// calling OneTick after each one?
+    int quietInstrs;		// if so, how many have we run so far
+
+    bool useBlocks;		// run user programs with the block engine?
+    List<TranslatedBlock *> *retiredBlocks;
+				// blocks that have been invalidated, but
+				// may still be in use by a thread that
+				// trapped out of the middle of one
+    bool blocksRetired;		// set whenever a block is retired, so a
+				// running block can tell it was modified
+    BlockOp *blockOp;		// the operation of the running block that
+				// may trap, or NULL
+    int blockTarget;		// where the running block's branch goes
+
+    int stallTicks;		// ticks the current instruction has spent
+				// waiting for cache misses, or beyond
+				// UserTick (see timing.h)
+
     bool singleStep;		// drop back into the debugger after each
 				// simulated instruction
     int runUntilTime;		// drop back into the debugger when simulated
@@ -186,9 +347,6 @@ extern void ExceptionHandler(ExceptionType which);
 				// user system calls and exceptions
 				// Defined in exception.cc
 
-extern void SimpleTLBMissHandler(int virtAddr);
-extern void TLBMissHandler(int virtAddr);
-
 // Routines for converting Words and Short Words to and from the
 // simulated machine's format of little endian.  If the host machine
 // is little endian (DEC and Intel), these end up being NOPs.
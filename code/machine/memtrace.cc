@@ -0,0 +1,257 @@
+// memtrace.cc
+//	Routines for writing a trace of the memory accesses made by user
+//	programs, and for reading it back (see memtrace.h for the format).
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "memtrace.h"
+#include "main.h"
+
+static const int MaxRecordSize = 16;	// a tag and three 5-byte numbers
+
+// Bits of a record's tag byte
+static const int TagKindMask = 0x03;
+static const int TagSizeShift = 2;
+static const int TagThread = 0x10;
+static const int TagOffset = 0x20;
+
+//----------------------------------------------------------------------
+// ZigZag, UnZigZag
+// 	Map signed numbers to unsigned ones so that numbers near zero,
+//	of either sign, stay small: 0, -1, 1, -2 ... -> 0, 1, 2, 3 ...
+//----------------------------------------------------------------------
+
+static unsigned int
+ZigZag(int n)
+{
+    return ((unsigned int)n << 1) ^ (unsigned int)(n >> 31);
+}
+
+static int
+UnZigZag(unsigned int n)
+{
+    return (int)(n >> 1) ^ -(int)(n & 1);
+}
+
+//----------------------------------------------------------------------
+// MemTrace::MemTrace
+// 	Create the trace file, and write its header.
+//
+//	"fileName" -- where to write the trace
+//	"sampleInterval" -- record one access in this many (1 records all)
+//----------------------------------------------------------------------
+
+MemTrace::MemTrace(char *fileName, int sampleInterval)
+{
+    int header[4];
+
+    ASSERT(sampleInterval > 0);
+    fd = OpenForWrite(fileName);
+    this->sampleInterval = sampleInterval;
+    untilSample = 1;
+
+    header[0] = MemTraceMagic;
+    header[1] = MemTraceVersion;
+    header[2] = PageSize;
+    header[3] = sampleInterval;
+    WriteFile(fd, (char *)header, sizeof(header));
+
+    block = new char[MemTraceBlockSize];
+    blockLength = MemTraceBlockSize;	// so that Flush writes nothing
+    blockRecords = 0;
+    Flush();
+}
+
+//----------------------------------------------------------------------
+// MemTrace::~MemTrace
+// 	Write out the records still in the block, and close the file.
+//----------------------------------------------------------------------
+
+MemTrace::~MemTrace()
+{
+    Flush();
+    Close(fd);
+    delete[] block;
+}
+
+//----------------------------------------------------------------------
+// MemTrace::Write
+// 	Add a record to the block, writing the block out first if there
+//	may not be room for it.
+//
+//	"kind" -- fetch, load or store
+//	"virtAddr", "physAddr" -- where the access was
+//	"size" -- 1, 2 or 4 bytes
+//----------------------------------------------------------------------
+
+void
+MemTrace::Write(MemTraceKind kind, int virtAddr, int physAddr, int size)
+{
+    int thread = kernel->currentThread->getTid();
+    int offset = physAddr - virtAddr;
+    char tag = kind | ((size >> 1) << TagSizeShift);
+
+    if (blockLength + MaxRecordSize > MemTraceBlockSize)
+	Flush();
+
+    if (thread != lastThread)
+	tag |= TagThread;
+    if (offset != lastOffset)
+	tag |= TagOffset;
+    block[blockLength++] = tag;
+    if (thread != lastThread)
+	PutNumber(thread);
+    if (offset != lastOffset)
+	PutNumber(ZigZag(offset));
+    PutNumber(ZigZag(virtAddr - lastAddr[kind]));
+
+    lastThread = thread;
+    lastOffset = offset;
+    lastAddr[kind] = virtAddr;
+    blockRecords++;
+}
+
+//----------------------------------------------------------------------
+// MemTrace::PutNumber
+// 	Add a number to the block, 7 bits a byte.
+//----------------------------------------------------------------------
+
+void
+MemTrace::PutNumber(unsigned int n)
+{
+    while (n >= 0x80) {
+	block[blockLength++] = (char)(n | 0x80);
+	n >>= 7;
+    }
+    block[blockLength++] = (char)n;
+}
+
+//----------------------------------------------------------------------
+// MemTrace::Flush
+// 	Write out the block, if it has anything in it, and start a new
+//	one, which is coded without reference to this one.
+//----------------------------------------------------------------------
+
+void
+MemTrace::Flush()
+{
+    int header[2];
+
+    if (blockRecords > 0) {
+	header[0] = blockRecords;
+	header[1] = blockLength;
+	WriteFile(fd, (char *)header, sizeof(header));
+	WriteFile(fd, block, blockLength);
+    }
+    blockLength = 0;
+    blockRecords = 0;
+    lastThread = -1;
+    lastOffset = 0;
+    for (int i = 0; i < NumTraceKinds; i++)
+	lastAddr[i] = 0;
+}
+
+//----------------------------------------------------------------------
+// MemTraceReader::MemTraceReader
+// 	Open a trace, and read its header.  If the file can't be opened,
+//	or isn't a trace, IsOpen will say so.
+//
+//	"fileName" -- the trace to read
+//----------------------------------------------------------------------
+
+MemTraceReader::MemTraceReader(char *fileName)
+{
+    int header[4];
+
+    block = new char[MemTraceBlockSize];
+    blockRecords = 0;
+    fd = OpenForReadWrite(fileName, FALSE);
+    if (fd < 0)
+	return;
+    if (ReadPartial(fd, (char *)header, sizeof(header)) != sizeof(header) ||
+	header[0] != MemTraceMagic || header[1] != MemTraceVersion) {
+	Close(fd);
+	fd = -1;
+	return;
+    }
+    pageSize = header[2];
+    sampleInterval = header[3];
+}
+
+MemTraceReader::~MemTraceReader()
+{
+    if (fd >= 0)
+	Close(fd);
+    delete[] block;
+}
+
+//----------------------------------------------------------------------
+// MemTraceReader::Next
+// 	Decode the next record, reading in the next block if this one
+//	is used up.
+//
+//	Returns FALSE at the end of the trace (or if the trace has been
+//	cut short).
+//
+//	"record" -- where to put the access
+//----------------------------------------------------------------------
+
+bool
+MemTraceReader::Next(MemTraceRecord *record)
+{
+    int header[2];
+    char tag;
+
+    if (fd < 0)
+	return FALSE;
+    if (blockRecords == 0) {
+	if (ReadPartial(fd, (char *)header, sizeof(header)) != sizeof(header)
+	    || header[1] < 0 || header[1] > MemTraceBlockSize
+	    || ReadPartial(fd, block, header[1]) != header[1])
+	    return FALSE;
+	blockRecords = header[0];
+	blockLength = header[1];
+	position = 0;
+	lastThread = -1;
+	lastOffset = 0;
+	for (int i = 0; i < NumTraceKinds; i++)
+	    lastAddr[i] = 0;
+    }
+
+    tag = block[position++];
+    if (tag & TagThread)
+	lastThread = GetNumber();
+    if (tag & TagOffset)
+	lastOffset = UnZigZag(GetNumber());
+    record->kind = (MemTraceKind)(tag & TagKindMask);
+    record->size = 1 << ((tag >> TagSizeShift) & 0x3);
+    record->thread = lastThread;
+    lastAddr[record->kind] += UnZigZag(GetNumber());
+    record->virtAddr = lastAddr[record->kind];
+    record->physAddr = record->virtAddr + lastOffset;
+    blockRecords--;
+    return (position <= blockLength);
+}
+
+//----------------------------------------------------------------------
+// MemTraceReader::GetNumber
+// 	Read a number written by MemTrace::PutNumber.
+//----------------------------------------------------------------------
+
+unsigned int
+MemTraceReader::GetNumber()
+{
+    unsigned int n = 0;
+    int shift = 0;
+    unsigned char byte;
+
+    do {
+	byte = block[position++];
+	n |= (unsigned int)(byte & 0x7f) << shift;
+	shift += 7;
+    } while ((byte & 0x80) && position < blockLength);
+    return n;
+}
@@ -0,0 +1,138 @@
+// memtrace.h
+//	Data structures for tracing the memory accesses of user programs.
+//
+//	When Nachos is started with "-mtrace <file>", the simulator writes
+//	each instruction fetch, load and store made by user programs to
+//	the file: the virtual and physical address, the size, the kind of
+//	access and the thread making it.  "-mtracesample <n>" keeps only
+//	every n'th access.  The trace can then be fed to cache or paging
+//	models without running the simulator again for each of them;
+//	"nachos -mtracedump <file>" prints it as text, one access a line,
+//	and MemTraceReader reads it for programs that link with it.
+//
+//	Tracing is done by the instruction-at-a-time simulator; the block
+//	engine (-bb) is turned off while it is on.
+//
+//	The file format:
+//
+//	A header of four ints, in the host's byte order: MemTraceMagic,
+//	MemTraceVersion, the page size and the sampling interval.
+//
+//	Then a series of blocks, each of two ints -- the number of records
+//	and the number of bytes in the block -- followed by the records.
+//	Addresses are coded as differences from the record before, so
+//	blocks start afresh: each can be decoded on its own.  A record is
+//
+//	    a tag byte --
+//		bits 0-1: the kind of access (MemTraceKind)
+//		bits 2-3: log2 of the size (1, 2 or 4 bytes)
+//		bit 4: the thread is different from the record before
+//		bit 5: physical - virtual address is different from the
+//		       record before (it is usually the same, within a page
+//		       and across identity-mapped pages)
+//	    the thread id, if bit 4 is set
+//	    physical - virtual address, if bit 5 is set
+//	    virtual address - the virtual address of the last access of
+//		the same kind (so straight-line code costs a byte per fetch)
+//
+//	Numbers after the tag are variable-length: 7 bits a byte, least
+//	significant first, with the top bit set on all but the last byte.
+//	Signed numbers are zig-zag coded first (0, -1, 1, -2, ... become
+//	0, 1, 2, 3, ...), so that small differences take a byte.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef MEMTRACE_H
+#define MEMTRACE_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "sysdep.h"
+
+const int MemTraceMagic = 0x4d545243;	// "MTRC"
+const int MemTraceVersion = 1;
+const int MemTraceBlockSize = 65536;	// bytes of records per block, at most
+
+enum MemTraceKind { TraceFetch, TraceLoad, TraceStore, NumTraceKinds };
+
+// The following class defines one memory access, as read back from a
+// trace.
+
+class MemTraceRecord {
+  public:
+    MemTraceKind kind;
+    int virtAddr;		// the address the program used
+    int physAddr;		// where it was in mainMemory
+    int size;			// 1, 2 or 4 bytes
+    int thread;			// the thread id (see Thread::getTid)
+};
+
+// The following class writes a trace, a block at a time.
+
+class MemTrace {
+  public:
+    MemTrace(char *fileName, int sampleInterval);
+				// start tracing to "fileName", keeping one
+				// access in every "sampleInterval"
+    ~MemTrace();		// write out the last block, and close the file
+
+    void Record(MemTraceKind kind, int virtAddr, int physAddr, int size) {
+	if (--untilSample == 0) {
+	    untilSample = sampleInterval;
+	    Write(kind, virtAddr, physAddr, size);
+	}
+    }				// a user program has accessed memory
+
+  private:
+    void Write(MemTraceKind kind, int virtAddr, int physAddr, int size);
+				// add a record to the block
+    void PutNumber(unsigned int n);
+				// add a variable-length number to the block
+    void Flush();		// write out the block, and start a new one
+
+    int fd;			// the trace file
+    int sampleInterval;		// keep one access in this many
+    int untilSample;		// accesses to skip before the next one
+    char *block;		// the records not yet written out
+    int blockLength;		// bytes in block
+    int blockRecords;		// records in block
+    int lastThread;		// what the last record had, to code the
+    int lastOffset;		// next one against; reset at each block
+    int lastAddr[NumTraceKinds];
+};
+
+// The following class reads a trace back, a record at a time.
+
+class MemTraceReader {
+  public:
+    MemTraceReader(char *fileName);
+				// open a trace
+    ~MemTraceReader();
+
+    bool IsOpen() { return fd >= 0; }
+				// is the file there, and a trace?
+    int getPageSize() { return pageSize; }
+    int getSampleInterval() { return sampleInterval; }
+				// what the header says
+
+    bool Next(MemTraceRecord *record);
+				// read the next access; FALSE at the end
+
+  private:
+    unsigned int GetNumber();	// read a variable-length number
+
+    int fd;			// the trace file, or -1
+    int pageSize;
+    int sampleInterval;
+    char *block;		// the block being read
+    int blockLength;		// bytes in block
+    int blockRecords;		// records left to read in block
+    int position;		// where the next record starts in block
+    int lastThread;		// as in MemTrace
+    int lastOffset;
+    int lastAddr[NumTraceKinds];
+};
+
+#endif // MEMTRACE_H
@@ -19,30 +19,35 @@
 #include "debug.h"
 #include "machine.h"
 #include "mipssim.h"
+#include "profile.h"
+#include "memtrace.h"
+#include "cache.h"
+#include "timing.h"
 #include "main.h"
 
 static void Mult(int a, int b, bool signedArith, int *hiPtr, int *loPtr);
 
-// The following class defines an instruction, represented in both
-// 	undecoded binary form
-//      decoded to identify
-//	    operation to do
-//	    registers to act on
-//	    any immediate operand value
+//----------------------------------------------------------------------
+// DecodedPage::DecodedPage
+// 	Initialize an empty decode cache for one physical page.
+//----------------------------------------------------------------------
 
-class Instruction
+DecodedPage::DecodedPage()
 {
-public:
-	void Decode(); // decode the binary representation of the instruction
-
-	unsigned int value; // binary representation of the instruction
+	instrs = new Instruction[PageSize / 4];
+	valid = new bool[PageSize / 4];
+	for (int i = 0; i < PageSize / 4; i++)
+		valid[i] = FALSE;
+	numValid = 0;
+	blocks = NULL;
+}
 
-	char opCode;	 // Type of instruction.  This is NOT the same as the
-					 // opcode field from the instruction: see defs in mips.h
-	char rs, rt, rd; // Three registers from instruction.
-	int extra;		 // Immediate or target or shamt field or offset.
-					 // Immediates are sign-extended.
-};
+DecodedPage::~DecodedPage()
+{
+	delete[] instrs;
+	delete[] valid;
+	delete[] blocks; // the blocks themselves belong to the Machine
+}
 
 //----------------------------------------------------------------------
 // Machine::Run
@@ -51,44 +56,131 @@ public:
 //
 //	This routine is re-entrant, in that it can be called multiple
 //	times concurrently -- one for each thread executing user code.
+//
+//	The simulator itself is Interpret, compiled once for each policy
+//	in mipssim.h.  We pick the one to use here, so that when nobody
+//	is single-stepping, tracing or profiling, the loop doesn't check
+//	for any of them on each instruction.
 //----------------------------------------------------------------------
 
 void Machine::Run()
 {
-	Instruction *instr = new Instruction; // storage for decoded instruction
-
 	if (debug->IsEnabled('m'))
 	{
 		cout << "Starting program in thread: " << kernel->currentThread->getName();
 		cout << ", at time: " << kernel->stats->totalTicks << "\n";
 	}
 	kernel->interrupt->setStatus(UserMode);
-#ifdef TLB_NRU
-	int co = 0;
-#endif
+
+	// The block engine skips the per-instruction fetch, debug output
+	// and tick, so only use it when nobody is watching for those.
+	// (Its loads and stores would be traced, but not its fetches.)
+	// It also only knows how to fetch through the page table.
+	if (useBlocks && tlb == NULL && !singleStep && kernel->profile == NULL &&
+		kernel->memTrace == NULL && !MayStall() &&
+		!debug->IsEnabled(dbgMach) && !debug->IsEnabled(dbgAddr) &&
+		!debug->IsEnabled(dbgInt))
+		RunBlocks(); // never returns
+
+	if (singleStep || kernel->profile != NULL || kernel->memTrace != NULL ||
+		MayStall() || debug->IsEnabled(dbgMach) || debug->IsEnabled(dbgInt))
+		Interpret<WatchedPolicy>(); // never returns
+	else
+		Interpret<FastPolicy>(); // never returns
+}
+
+//----------------------------------------------------------------------
+// Machine::Interpret
+// 	Run user instructions one at a time, forever.  The body of Run.
+//
+//	Calling OneTick after every instruction only matters on the tick
+//	at which an interrupt is due, so unless we are single-stepping
+//	or tracing interrupts, we find out how many instructions we can
+//	run before that (see Interrupt::QuietTicks), run them one after
+//	another, and then charge for them in one go.  If one of them
+//	traps, RaiseException charges for the ones before it, and the
+//	trapping instruction gets its OneTick as usual.
+//
+//	Cache misses and the timing model make an instruction take more
+//	than one tick, so while either is on we don't batch ticks, and
+//	charge for the extra ticks after each instruction (see Stall).
+//
+//	"Policy" -- which of the checks for single-stepping, tracing and
+//		profiling to compile in (see mipssim.h)
+//----------------------------------------------------------------------
+
+template <class Policy>
+void Machine::Interpret()
+{
+	int quiet = 0; // instructions we may run before the next OneTick
 	for (;;)
 	{
-		OneInstruction(instr);
-#ifdef TLB_NRU
-		// 添加nru
-		if (co == 99)
+		if (!runningQuietly &&
+			!(Policy::stepping &&
+			  (singleStep || debug->IsEnabled(dbgInt) || MayStall())))
 		{
-			// 按时钟周期，对访问位清零：
-			cout << "Reach 100 Ticks, set USE to zero\n";
-			for (int i = 0; i < TLBSize; ++i)
-			{
-				kernel->machine->tlb[i].use = false;
-				cout << "tlb[" << i <<"].use is set to " << tlb[i].use << endl;
-			}
+			quiet = kernel->interrupt->QuietTicks() / UserTick;
+			quietInstrs = 0;
+			runningQuietly = (quiet > 0);
+		}
+
+		OneInstruction<Policy>();
+		if (runningQuietly)
+		{
+			if (++quietInstrs < quiet)
+				continue;
+			runningQuietly = FALSE;
+			kernel->interrupt->AdvanceQuietly(quietInstrs * UserTick);
+			continue;
 		}
-		co = (co + 1) % 100;
-#endif
 		kernel->interrupt->OneTick();
-		if (singleStep && (runUntilTime <= kernel->stats->totalTicks))
+		if (Policy::stepping && stallTicks > 0)
+			Stall();
+		if (Policy::stepping && singleStep &&
+			(runUntilTime <= kernel->stats->totalTicks))
 			Debugger();
 	}
 }
 
+//----------------------------------------------------------------------
+// Machine::UseCache
+// 	Look up a physical address in a cache, counting a hit or a miss;
+//	a miss also stalls the current instruction.
+//
+//	"cache" -- the instruction or data cache
+//	"physAddr" -- the address being accessed
+//	"hits", "misses" -- the counters in Statistics to add to
+//----------------------------------------------------------------------
+
+void Machine::UseCache(Cache *cache, int physAddr, int *hits, int *misses)
+{
+	if (cache->Access(physAddr))
+		(*hits)++;
+	else
+	{
+		(*misses)++;
+		stallTicks += cache->MissPenalty();
+	}
+}
+
+//----------------------------------------------------------------------
+// Machine::Stall
+// 	Charge for the ticks the last instruction spent waiting for the
+//	caches, or took beyond UserTick.  They are charged one at a time,
+//	as if they were more instructions, so that interrupts still happen
+//	on time.
+//----------------------------------------------------------------------
+
+void Machine::Stall()
+{
+	int ticks = stallTicks;
+
+	stallTicks = 0; // before OneTick, which may switch threads
+	kernel->stats->stallTicks += ticks;
+	for (; ticks > 0; ticks -= UserTick)
+		kernel->interrupt->OneTick();
+}
+
 //----------------------------------------------------------------------
 // TypeToReg
 // 	Retrieve the register # referred to in an instruction.
@@ -133,26 +225,86 @@ TypeToReg(RegType reg, Instruction *instr)
 //	leaving.  This allows the Nachos kernel to control our behavior
 //	by controlling the contents of memory, the translation table,
 //	and the register set.
+//
+//	"Policy" -- which per-instruction checks to make (see mipssim.h)
 //----------------------------------------------------------------------
 
-void Machine::OneInstruction(Instruction *instr)
+template <class Policy>
+void Machine::OneInstruction()
+{
+	Instruction *instr;
+
+	// Fetch instruction
+	instr = FetchInstruction<Policy>();
+	if (instr == NULL)
+		return; // exception occurred
+
+	if (Policy::profiling && (kernel->profile != NULL || timing != NULL))
+		ExecuteWatched(instr);
+	else
+		ExecuteInstruction<Policy>(instr);
+}
+
+//----------------------------------------------------------------------
+// Machine::ExecuteWatched
+// 	Execute one instruction, as ExecuteInstruction does, while
+//	counting it in the profile and charging it by the timing model,
+//	whichever of them is on.  Both want to know if it was a taken
+//	branch or jump, which only shows after it is run.
+//
+//	"instr" -- the decoded instruction at registers[PCReg]
+//----------------------------------------------------------------------
+
+void Machine::ExecuteWatched(Instruction *instr)
+{
+	int nextPC = registers[NextPCReg];
+	CallNode **context = &kernel->currentThread->callNode;
+
+	if (kernel->profile != NULL)
+		kernel->profile->CountInstruction(registers[PCReg], instr->opCode, context);
+	if (timing != NULL)
+		stallTicks += timing->Cost(instr);
+	ExecuteInstruction<WatchedPolicy>(instr);
+
+	// if the instruction went on to nextPC, but isn't followed by
+	// nextPC + 4, it was a jump or a taken branch
+	if (registers[PCReg] == nextPC && registers[NextPCReg] != nextPC + 4)
+	{
+		if (timing != NULL)
+			stallTicks += timing->TakenCost();
+		if (kernel->profile == NULL)
+			return;
+		kernel->profile->CountTaken();
+		if (instr->opCode == OP_JAL || instr->opCode == OP_JALR)
+			kernel->profile->CountCall(registers[NextPCReg], context);
+		else if (instr->opCode == OP_JR && instr->rs == RetAddrReg)
+			kernel->profile->CountReturn(context);
+	}
+}
+
+//----------------------------------------------------------------------
+// Machine::ExecuteInstruction
+// 	Execute one instruction that has already been fetched from the
+//	current PC, advancing the program counters when it is done.
+//	The second half of OneInstruction; the block engine (blocksim.cc)
+//	also calls it for the instructions it doesn't translate itself.
+//
+//	"instr" -- the decoded instruction at registers[PCReg]
+//	"Policy" -- whether to trace the instruction (see mipssim.h)
+//----------------------------------------------------------------------
+
+template <class Policy>
+void Machine::ExecuteInstruction(Instruction *instr)
 {
 #ifdef SIM_FIX
 	int byte; // described in Kane for LWL,LWR,...
 #endif
 
-	int raw;
 	int nextLoadReg = 0;
 	int nextLoadValue = 0; // record delayed load operation, to apply
 						   // in the future
 
-	// Fetch instruction
-	if (!ReadMem(registers[PCReg], 4, &raw))
-		return; // exception occurred
-	instr->value = raw;
-	instr->Decode();
-
-	if (debug->IsEnabled('m'))
+	if (Policy::tracing && debug->IsEnabled('m'))
 	{
 		struct OpString *str = &opStrings[instr->opCode];
 		char buf[80];
@@ -321,7 +473,9 @@ void Machine::OneInstruction(Instruction *instr)
 		break;
 
 	case OP_LUI:
-		DEBUG(dbgMach, "Executing: LUI r" << instr->rt << ", " << instr->extra);
+		if (Policy::tracing) {
+			DEBUG(dbgMach, "Executing: LUI r" << instr->rt << ", " << instr->extra);
+		}
 		registers[instr->rt] = instr->extra << 16;
 		break;
 
@@ -724,16 +878,186 @@ void Machine::OneInstruction(Instruction *instr)
 	registers[NextPCReg] = pcAfter;
 }
 
+// The block engine (blocksim.cc) runs the instructions it doesn't
+// translate itself with these, so compile them here for it.
+template void Machine::OneInstruction<FastPolicy>();
+template void Machine::ExecuteInstruction<FastPolicy>(Instruction *instr);
+
+//----------------------------------------------------------------------
+// Machine::FetchInstruction
+// 	Fetch the instruction at the current PC, and return its decoded
+//	form.  The PC is translated exactly as ReadMem would do it (so that
+//	page faults and TLB misses happen as before), but the word is only
+//	read and decoded if the decode cache doesn't already hold it.
+//
+//	Returns NULL if the translation raised an exception.
+//
+//	"Policy" -- whether memory accesses may be being traced, or go
+//		through an instruction cache
+//----------------------------------------------------------------------
+
+template <class Policy>
+Instruction *
+Machine::FetchInstruction()
+{
+	int virtAddr = registers[PCReg];
+	int physAddr;
+	ExceptionType exception;
+	char *host;
+
+	host = QuickTranslate(virtAddr, 4, FALSE);
+	if (host != NULL)
+	{
+		if (Policy::tracing && kernel->memTrace != NULL)
+			kernel->memTrace->Record(TraceFetch, virtAddr, host - mainMemory, 4);
+		if (Policy::stepping && iCache != NULL)
+			UseCache(iCache, host - mainMemory, &kernel->stats->iCacheHits,
+					 &kernel->stats->iCacheMisses);
+		return DecodeWord(host - mainMemory);
+	}
+
+	DEBUG(dbgAddr, "-----------------------\nFetching VA " << virtAddr);
+
+	exception = Translate(virtAddr, &physAddr, 4, FALSE);
+	if (exception != NoException)
+	{
+		RaiseException(exception, virtAddr);
+		// as in ReadMem, retry once the page fault has been handled
+		if (exception != PageFaultException)
+			return NULL;
+		if (Translate(virtAddr, &physAddr, 4, FALSE) != NoException)
+			return NULL;
+	}
+	FillSoftTLB(virtAddr);
+	if (Policy::tracing && kernel->memTrace != NULL)
+		kernel->memTrace->Record(TraceFetch, virtAddr, physAddr, 4);
+	if (Policy::stepping && iCache != NULL)
+		UseCache(iCache, physAddr, &kernel->stats->iCacheHits,
+				 &kernel->stats->iCacheMisses);
+
+	return DecodeWord(physAddr);
+}
+
+//----------------------------------------------------------------------
+// Machine::DecodeWord
+// 	Return the decoded form of the word at a physical address, from
+//	the decode cache if it is there, otherwise decoding it now.
+//
+//	"physAddr" -- the (word aligned) physical address of the instruction
+//----------------------------------------------------------------------
+
+Instruction *
+Machine::DecodeWord(int physAddr)
+{
+	DecodedPage *page = decodeCache[physAddr >> PageShift];
+	Instruction *instr;
+	int index;
+
+	if (page == NULL)
+	{
+		page = new DecodedPage;
+		decodeCache[physAddr >> PageShift] = page;
+	}
+	index = (physAddr & (PageSize - 1)) >> 2;
+	instr = &page->instrs[index];
+	if (!page->valid[index])
+	{
+		instr->value = WordToHost(*(unsigned int *)&mainMemory[physAddr]);
+		instr->Decode();
+		page->valid[index] = TRUE;
+		page->numValid++;
+	}
+	return instr;
+}
+
+//----------------------------------------------------------------------
+// Machine::InvalidateCode
+// 	Called on every store into simulated memory.  If the word being
+//	written has been decoded, the decoded copy is now stale, so throw
+//	it away, along with any translated block that contains it.
+//	Stores are always within one aligned word.
+//
+//	"physAddr" -- the physical address being written
+//----------------------------------------------------------------------
+
+void Machine::InvalidateCode(int physAddr)
+{
+	DecodedPage *page = decodeCache[physAddr >> PageShift];
+	int index;
+
+	if (page == NULL || page->numValid == 0)
+		return; // no code decoded from this page
+	index = (physAddr & (PageSize - 1)) >> 2;
+	if (page->valid[index])
+	{
+		page->valid[index] = FALSE;
+		page->numValid--;
+		if (page->blocks != NULL)
+			RetireBlocks(page, index);
+	}
+}
+
+//----------------------------------------------------------------------
+// Machine::FlushDecodeCache
+// 	Invalidate every decoded instruction and translated block.
+//	The pages themselves are kept (an instruction being executed may
+//	still point into one); they are only de-allocated when the
+//	machine is.
+//----------------------------------------------------------------------
+
+void Machine::FlushDecodeCache()
+{
+	for (int i = 0; i < NumPhysPages; i++)
+	{
+		DecodedPage *page = decodeCache[i];
+
+		if (page != NULL && page->numValid > 0)
+		{
+			for (int j = 0; j < PageSize / 4; j++)
+				page->valid[j] = FALSE;
+			page->numValid = 0;
+			if (page->blocks != NULL)
+				RetireBlocks(page, -1);
+		}
+	}
+}
+
+//----------------------------------------------------------------------
+// Machine::DeleteDecodeCache
+// 	De-allocate the decode cache, when the machine is shut down.
+//----------------------------------------------------------------------
+
+void Machine::DeleteDecodeCache()
+{
+	for (int i = 0; i < NumPhysPages; i++)
+	{
+		if (decodeCache[i] != NULL && decodeCache[i]->blocks != NULL)
+			RetireBlocks(decodeCache[i], -1);
+		delete decodeCache[i];
+	}
+	delete[] decodeCache;
+	FreeRetiredBlocks();
+}
+
 //----------------------------------------------------------------------
 // Machine::DelayedLoad
 // 	Simulate effects of a delayed load.
 //
 // 	NOTE -- RaiseException/CheckInterrupts must also call DelayedLoad,
 //	since any delayed load must get applied before we trap to the kernel.
+//
+//	Most instructions are not loads, and don't follow one, so there is
+//	no load to finish and none to start; then all we need to do is
+//	keep R0 zero, without going through LoadReg and LoadValueReg.
 //----------------------------------------------------------------------
 
 void Machine::DelayedLoad(int nextReg, int nextValue)
 {
+	if ((registers[LoadReg] | registers[LoadValueReg] | nextReg | nextValue) == 0)
+	{
+		registers[0] = 0;
+		return;
+	}
 	registers[registers[LoadReg]] = registers[LoadValueReg];
 	registers[LoadReg] = nextReg;
 	registers[LoadValueReg] = nextValue;
@@ -0,0 +1,88 @@
+// native.cc
+//	Routines to load a library of compiled blocks (see native.h).
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "native.h"
+#include "machine.h"
+#include "main.h"
+#include <dlfcn.h>
+
+//----------------------------------------------------------------------
+// NativeCode::NativeCode
+// 	Load a library of compiled blocks.  If it can't be loaded, or was
+//	made for another page size or version, say so; the blocks will
+//	then all be run by the block engine.
+//
+//	"fileName" -- the shared library, as built from the output of
+//		noff2c
+//----------------------------------------------------------------------
+
+NativeCode::NativeCode(char *fileName)
+{
+    ASSERT(NativeHiReg == HiReg && NativeLoReg == LoReg);
+    ASSERT(NativeLoadReg == LoadReg && NativeLoadValueReg == LoadValueReg);
+
+    module = NULL;
+    if (strchr(fileName, '/') == NULL) {
+	// dlopen would look for a bare name on the library path
+	char *path = new char[strlen(fileName) + 3];
+	sprintf(path, "./%s", fileName);
+	handle = dlopen(path, RTLD_NOW);
+	delete[] path;
+    } else
+	handle = dlopen(fileName, RTLD_NOW);
+    if (handle == NULL) {
+	cerr << "Unable to load " << fileName << ": " << dlerror() << "\n";
+	return;
+    }
+    module = (const NativeModule *) dlsym(handle, NativeModuleName);
+    if (module == NULL)
+	cerr << fileName << " has no compiled blocks\n";
+    else if (module->version != NativeVersion) {
+	cerr << fileName << " is for another version of Nachos\n";
+	module = NULL;
+    } else if (module->pageSize != PageSize) {
+	cerr << fileName << " was compiled for pages of " <<
+	    module->pageSize << " bytes\n";
+	module = NULL;
+    }
+}
+
+NativeCode::~NativeCode()
+{
+    if (handle != NULL)
+	dlclose(handle);
+}
+
+//----------------------------------------------------------------------
+// NativeCode::Find
+// 	Return the block compiled to start at a virtual address, or NULL
+//	if there isn't one.  The caller has to check that it was compiled
+//	from what is in memory now.
+//
+//	"virtAddr" -- the address of the first instruction of the block
+//----------------------------------------------------------------------
+
+const NativeBlock *
+NativeCode::Find(int virtAddr)
+{
+    int low = 0, high, middle;
+
+    if (module == NULL)
+	return NULL;
+    high = module->numBlocks - 1;
+    while (low <= high) {	// the blocks are sorted by address
+	middle = (low + high) / 2;
+	if (module->blocks[middle].virtAddr == virtAddr)
+	    return &module->blocks[middle];
+	if (module->blocks[middle].virtAddr < virtAddr)
+	    low = middle + 1;
+	else
+	    high = middle - 1;
+    }
+    return NULL;
+}
@@ -0,0 +1,121 @@
+// native.h
+//	Data structures for running user programs that have been compiled
+//	ahead of time into host code.
+//
+//	Even the block engine (blocksim.cc) goes through a dispatch for
+//	every user instruction.  For long-running programs, noff2c (in
+//	the coff2noff directory) translates the code segment of a NOFF
+//	file into C, one function per basic block, which is compiled into
+//	a shared library:
+//
+//		noff2c matmult.noff matmult.c
+//		gcc -m32 -O2 -shared -fPIC -I../machine matmult.c -o matmult.so
+//
+//	and loaded with "nachos -native matmult.so -x matmult.noff".  The
+//	block engine then runs the compiled function in place of its own
+//	translation of a block, whenever the library has one for the
+//	block's address that was compiled from the very same instruction
+//	words as are in memory.  So a library can be loaded alongside any
+//	program: blocks of other programs, blocks the program has written
+//	over, and blocks starting where noff2c didn't expect one, are
+//	simply run by the block engine as before.
+//
+//	A compiled block works on the Machine's registers directly.  It
+//	does the arithmetic, logical and branch instructions itself, with
+//	the delayed loads worked out when it was compiled, and hands the
+//	rest -- loads, stores, system calls, and the instructions that
+//	can trap -- back to the simulator one at a time (NativeContext::
+//	step), so that memory faults and system calls reach the
+//	ExceptionHandler exactly as they would otherwise.  Time is charged
+//	as for the block engine, so the results are the same.
+//
+//	This file is included by the generated C, so the part of it that
+//	the library shares with Nachos is plain C.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef NATIVE_H
+#define NATIVE_H
+
+#define NativeVersion 1		// changes whenever the structures do
+#define NativeModuleName "nachosNativeModule"
+				// the symbol the library defines
+
+// The registers a compiled block uses, besides the 32 general ones
+// (the same as in machine.h).
+
+#define NativeHiReg 32
+#define NativeLoReg 33
+#define NativeLoadReg 37
+#define NativeLoadValueReg 38
+
+// What a compiled block is given to run with.
+
+typedef struct NativeContext NativeContext;
+
+struct NativeContext {
+    int target;			// where the block's branch goes, once the
+				// branch has been run
+    int (*step)(NativeContext *context, int index);
+				// run the index'th instruction of the block
+				// with the simulator; returns 0 if the block
+				// must stop (the instruction trapped, or
+				// wrote over code), having brought the
+				// registers and clock up to date
+};
+
+// One compiled basic block.  The block is the same one the block engine
+// would translate starting at virtAddr (see Machine::TranslateBlock).
+
+typedef struct NativeBlock {
+    int virtAddr;		// the address of the first instruction
+    int numInstrs;		// instructions run by the block
+    int numWords;		// words the block was compiled from
+    int branch;			// does it end with a branch and its delay
+				// slot?
+    const unsigned int *words;	// what those words were
+    int (*run)(NativeContext *context, int *registers);
+				// run the block on the Machine's
+				// registers; returns 0 if it stopped
+				// early, in step
+} NativeBlock;
+
+// Everything in a library.
+
+typedef struct NativeModule {
+    int version;		// NativeVersion
+    int pageSize;		// blocks never cross pages of this size
+    int numBlocks;
+    const NativeBlock *blocks;	// sorted by virtAddr
+} NativeModule;
+
+#ifdef __cplusplus
+
+#include "copyright.h"
+#include "utility.h"
+
+// The following class defines a library of compiled blocks, as loaded
+// into Nachos.
+
+class NativeCode {
+  public:
+    NativeCode(char *fileName);	// load the library
+    ~NativeCode();		// and unload it
+
+    bool IsLoaded() { return module != NULL; }
+				// was the library there, and usable?
+
+    const NativeBlock *Find(int virtAddr);
+				// the block compiled to start at virtAddr,
+				// or NULL
+
+  private:
+    void *handle;		// from dlopen
+    const NativeModule *module;	// what the library defines, or NULL
+};
+
+#endif // __cplusplus
+
+#endif // NATIVE_H
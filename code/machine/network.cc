@@ -32,7 +32,7 @@ NetworkInput::NetworkInput(CallBackObj *toCall)
 						 // in the current directory.
 
     // start polling for incoming packets
-    kernel->interrupt->Schedule(this, NetworkTime, NetworkRecvInt);
+    kernel->interrupt->Schedule(this, NetworkTime, NetworkRecvInt, sock);
 }
 
 //-----------------------------------------------------------------------
@@ -61,7 +61,7 @@ void
 NetworkInput::CallBack()
 {
     // schedule the next time to poll for a packet
-    kernel->interrupt->Schedule(this, NetworkTime, NetworkRecvInt);
+    kernel->interrupt->Schedule(this, NetworkTime, NetworkRecvInt, sock);
 
     if (inHdr.length != 0) 	// do nothing if packet is already buffered
 	return;		
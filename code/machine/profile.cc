@@ -0,0 +1,542 @@
+// profile.cc
+//	Routines for profiling user programs: keeping counts of the
+//	instructions run, and reporting them at the end.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "profile.h"
+#include "mipssim.h"
+#include "main.h"
+
+static const int NumHottest = 10;	// how many of each to print
+
+// A function, as named in the symbol table
+
+class Symbol {
+  public:
+    int address;		// where the function starts
+    char *name;
+};
+
+// The time spent in a function, over all the places it is called from
+
+class FunctionTotal {
+  public:
+    int function;		// the address of the function
+    int inclusive;		// instructions run in it, or in its callees
+    int exclusive;		// instructions run in it
+    CallNode *lastNode;		// the last call stack AddTotals found it on
+};
+
+//----------------------------------------------------------------------
+// NextNode
+// 	Return the node after "node" in a pre-order walk of the tree
+//	under "root", or NULL at the end.
+//----------------------------------------------------------------------
+
+static CallNode *
+NextNode(CallNode *node, CallNode *root)
+{
+    if (node->children != NULL)
+	return node->children;
+    for (; node != root; node = node->parent)
+	if (node->sibling != NULL)
+	    return node->sibling;
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// CompareSymbols, CompareTotals
+// 	Order symbols by address, and functions by decreasing inclusive
+//	time, for qsort.
+//----------------------------------------------------------------------
+
+static int
+CompareSymbols(const void *a, const void *b)
+{
+    return ((Symbol *)a)->address - ((Symbol *)b)->address;
+}
+
+static int
+CompareTotals(const void *a, const void *b)
+{
+    return ((FunctionTotal *)b)->inclusive - ((FunctionTotal *)a)->inclusive;
+}
+
+//----------------------------------------------------------------------
+// OpName
+// 	Copy the name of an instruction (eg, "ADDIU") out of opStrings.
+//
+//	"opCode" -- the OP_ code of the instruction
+//	"name" -- where to put the name; must hold at least 8 characters
+//----------------------------------------------------------------------
+
+static void
+OpName(int opCode, char *name)
+{
+    char *format = opStrings[opCode].format;
+    int i;
+
+    if (opCode > OP_SYSCALL || strncmp(format, "Shouldn't", 9) == 0)
+    { // not a real instruction
+	strcpy(name, "?");
+	return;
+    }
+    for (i = 0; i < 7 && format[i] != ' ' && format[i] != '\0'; i++)
+	name[i] = format[i];
+    name[i] = '\0';
+}
+
+//----------------------------------------------------------------------
+// Hottest
+// 	Find the largest entry of "counts" that isn't already in "chosen",
+//	and add it to "chosen".  Return its index, or -1 if there are no
+//	more non-zero entries.
+//----------------------------------------------------------------------
+
+static int
+Hottest(int *counts, int numCounts, bool *chosen)
+{
+    int best = -1;
+
+    for (int i = 0; i < numCounts; i++)
+	if (!chosen[i] && counts[i] > 0 &&
+	    (best == -1 || counts[i] > counts[best]))
+	    best = i;
+    if (best != -1)
+	chosen[best] = TRUE;
+    return best;
+}
+
+//----------------------------------------------------------------------
+// CallNode::CallNode
+// 	Add a function to the calling context tree.  It has not yet run
+//	any instructions, or called anything.
+//
+//	"function" -- the address of the function
+//	"parent" -- the node for its caller, or NULL
+//----------------------------------------------------------------------
+
+CallNode::CallNode(int function, CallNode *parent)
+{
+    this->function = function;
+    this->parent = parent;
+    children = NULL;
+    sibling = NULL;
+    self = 0;
+}
+
+//----------------------------------------------------------------------
+// CallNode::Child
+// 	Return the node for a call to "function" from this node, adding
+//	it if this is the first time this node has called it.
+//----------------------------------------------------------------------
+
+CallNode *
+CallNode::Child(int function)
+{
+    CallNode *child;
+
+    for (child = children; child != NULL; child = child->sibling)
+	if (child->function == function)
+	    return child;
+    child = new CallNode(function, this);
+    child->sibling = children;
+    children = child;
+    return child;
+}
+
+//----------------------------------------------------------------------
+// Profile::Profile
+// 	Start with all counts at zero.
+//
+//	"fileName" -- where to write the counts when Nachos halts
+//	"symbolFile" -- where to find function names, or NULL
+//----------------------------------------------------------------------
+
+Profile::Profile(char *fileName, char *symbolFile)
+{
+    this->fileName = fileName;
+    pcCounts = NULL;
+    pcOps = NULL;
+    numPCs = 0;
+    for (int i = 0; i < NumOpcodes; i++)
+	opCounts[i] = 0;
+    takenBranches = 0;
+    roots = NULL;
+    symbols = NULL;
+    numSymbols = 0;
+    functionTotals = NULL;
+    numFunctions = 0;
+    if (symbolFile != NULL)
+	ReadSymbols(symbolFile);
+}
+
+//----------------------------------------------------------------------
+// Profile::~Profile
+//----------------------------------------------------------------------
+
+Profile::~Profile()
+{
+    CallNode *node, *parent;
+
+    delete[] pcCounts;
+    delete[] pcOps;
+    for (node = roots; node != NULL; )
+    { // delete the leaves, until there's nothing left
+	if (node->children != NULL)
+	{
+	    node = node->children;
+	    continue;
+	}
+	parent = node->parent;
+	if (parent != NULL)
+	    parent->children = node->sibling;
+	else
+	    roots = node->sibling;
+	delete node;
+	node = (parent != NULL) ? parent : roots;
+    }
+    for (int i = 0; i < numSymbols; i++)
+	delete[] symbols[i].name;
+    delete[] symbols;
+    delete[] functionTotals;
+}
+
+//----------------------------------------------------------------------
+// Profile::GrowPCs
+// 	Make the per-instruction counts big enough to cover "pc".  They
+//	start out empty, and at least double each time, so that this
+//	doesn't happen often.
+//----------------------------------------------------------------------
+
+void
+Profile::GrowPCs(int pc)
+{
+    int newSize = max(numPCs * 2, (int)((unsigned)pc / 4 + 1));
+    int *newCounts = new int[newSize];
+    char *newOps = new char[newSize];
+
+    for (int i = 0; i < newSize; i++)
+    {
+	newCounts[i] = (i < numPCs) ? pcCounts[i] : 0;
+	newOps[i] = (i < numPCs) ? pcOps[i] : 0;
+    }
+    delete[] pcCounts;
+    delete[] pcOps;
+    pcCounts = newCounts;
+    pcOps = newOps;
+    numPCs = newSize;
+}
+
+//----------------------------------------------------------------------
+// Profile::Root
+// 	Return the node for a thread that starts running user code in
+//	"function".  All threads that start at the same place share it.
+//----------------------------------------------------------------------
+
+CallNode *
+Profile::Root(int function)
+{
+    CallNode *root;
+
+    for (root = roots; root != NULL; root = root->sibling)
+	if (root->function == function)
+	    return root;
+    root = new CallNode(function, NULL);
+    root->sibling = roots;
+    roots = root;
+    return root;
+}
+
+//----------------------------------------------------------------------
+// Profile::ReadSymbols
+// 	Read the names of the functions in the user program, from a file
+//	with one symbol per line, as printed by nm:
+//
+//		<address in hex> <type> <name>
+//
+//	Only symbols in the text segment (type t or T) are kept.
+//----------------------------------------------------------------------
+
+void
+Profile::ReadSymbols(char *symbolFile)
+{
+    FILE *file = fopen(symbolFile, "r");
+    char line[256], name[200];
+    unsigned int address;
+    char type;
+    int size = 0;
+
+    if (file == NULL)
+    {
+	cerr << "Unable to read symbols " << symbolFile << "\n";
+	return;
+    }
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+	if (sscanf(line, "%x %c %199s", &address, &type, name) != 3 ||
+	    (type != 't' && type != 'T'))
+	    continue;
+	if (numSymbols == size)
+	{ // make room for more
+	    Symbol *old = symbols;
+	    size = max(2 * size, 64);
+	    symbols = new Symbol[size];
+	    for (int i = 0; i < numSymbols; i++)
+		symbols[i] = old[i];
+	    delete[] old;
+	}
+	symbols[numSymbols].address = address;
+	symbols[numSymbols].name = new char[strlen(name) + 1];
+	strcpy(symbols[numSymbols].name, name);
+	numSymbols++;
+    }
+    fclose(file);
+    qsort(symbols, numSymbols, sizeof(Symbol), CompareSymbols);
+}
+
+//----------------------------------------------------------------------
+// Profile::FunctionName
+// 	Return the name of the function "address" is in: the nearest
+//	symbol at or below it, or else the address itself, in hex.  The
+//	result is only good until the next call.
+//----------------------------------------------------------------------
+
+char *
+Profile::FunctionName(int address)
+{
+    static char hex[16];
+    int low = 0, high = numSymbols - 1, mid;
+
+    while (low <= high)
+    { // find the last symbol at or below address
+	mid = (low + high) / 2;
+	if (symbols[mid].address <= address)
+	    low = mid + 1;
+	else
+	    high = mid - 1;
+    }
+    if (high >= 0)
+	return symbols[high].name;
+    sprintf(hex, "0x%x", address);
+    return hex;
+}
+
+//----------------------------------------------------------------------
+// Profile::FindTotal
+// 	Return the entry in functionTotals for "function", adding it if
+//	there isn't one yet.  functionTotals has room for one entry per
+//	node, so it never has to grow.
+//----------------------------------------------------------------------
+
+FunctionTotal *
+Profile::FindTotal(int function)
+{
+    FunctionTotal *total;
+
+    for (int i = 0; i < numFunctions; i++)
+	if (functionTotals[i].function == function)
+	    return &functionTotals[i];
+    total = &functionTotals[numFunctions++];
+    total->function = function;
+    total->inclusive = total->exclusive = 0;
+    total->lastNode = NULL;
+    return total;
+}
+
+//----------------------------------------------------------------------
+// Profile::AddTotals
+// 	Add the time spent in each calling context to the functions on
+//	its call stack: all of them get it as inclusive time (once, even
+//	if a function is on the stack more than once), and the function
+//	at the top gets it as exclusive time.
+//
+//	Like the other walks over the call graph, this is a loop rather
+//	than a recursion, as the call stacks of the user program may be
+//	much deeper than the kernel stack we are running on.
+//----------------------------------------------------------------------
+
+void
+Profile::AddTotals(CallNode *root)
+{
+    FunctionTotal *total;
+    CallNode *frame;
+
+    for (CallNode *node = root; node != NULL; node = NextNode(node, root))
+    {
+	if (node->self == 0)
+	    continue;
+	FindTotal(node->function)->exclusive += node->self;
+	for (frame = node; frame != NULL; frame = frame->parent)
+	{
+	    total = FindTotal(frame->function);
+	    if (total->lastNode != node)
+	    { // first time we've seen it on this stack
+		total->lastNode = node;
+		total->inclusive += node->self;
+	    }
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// Profile::WriteFolded
+// 	Write out one line for each calling context under "root" that
+//	ran any instructions itself: the functions on the call stack,
+//	outermost first, separated by ';', and then the time.
+//----------------------------------------------------------------------
+
+void
+Profile::WriteFolded(FILE *file, CallNode *root)
+{
+    CallNode **stack;
+    CallNode *frame;
+    int depth;
+
+    for (CallNode *node = root; node != NULL; node = NextNode(node, root))
+    {
+	if (node->self == 0)
+	    continue;
+	depth = 0;
+	for (frame = node; frame != NULL; frame = frame->parent)
+	    depth++;
+	stack = new CallNode *[depth];
+	depth = 0;
+	for (frame = node; frame != NULL; frame = frame->parent)
+	    stack[depth++] = frame;
+	while (--depth >= 0)
+	    fprintf(file, "%s%c", FunctionName(stack[depth]->function),
+		    (depth > 0) ? ';' : ' ');
+	fprintf(file, "%d\n", node->self);
+	delete[] stack;
+    }
+}
+
+//----------------------------------------------------------------------
+// Profile::Print
+// 	Print the totals and the hottest instructions, opcodes and
+//	functions, then write every non-zero count to the profile file:
+//
+//		total <instructions|loads|stores|taken> <count>
+//		op <name> <count>
+//		pc <address> <count> <name>
+//		func <name> <inclusive count> <exclusive count>
+//
+//	and the call stacks to the folded file.
+//----------------------------------------------------------------------
+
+void
+Profile::Print()
+{
+    int total = 0, loads = 0, stores = 0;
+    bool *chosen;
+    char name[8];
+    int i, best, numNodes;
+    CallNode *root, *node;
+    FILE *file;
+    char *foldedName;
+
+    for (i = 0; i < NumOpcodes; i++)
+    {
+	total += opCounts[i];
+	if ((i >= OP_LB && i <= OP_LWR && i != OP_LUI))
+	    loads += opCounts[i];
+	else if (i == OP_SB || i == OP_SH ||
+		 (i >= OP_SW && i <= OP_SWR))
+	    stores += opCounts[i];
+    }
+
+    cout << "Profile: instructions " << total << ", loads " << loads;
+    cout << ", stores " << stores << ", taken branches " << takenBranches << "\n";
+
+    cout << "Hottest instructions:";
+    chosen = new bool[max(numPCs, NumOpcodes)];
+    for (i = 0; i < numPCs; i++)
+	chosen[i] = FALSE;
+    for (i = 0; i < NumHottest; i++)
+    {
+	best = Hottest(pcCounts, numPCs, chosen);
+	if (best == -1)
+	    break;
+	OpName(pcOps[best], name);
+	cout << " " << best * 4 << " " << name << " (" << pcCounts[best] << ")";
+    }
+    cout << "\n";
+
+    cout << "Hottest opcodes:";
+    for (i = 0; i < NumOpcodes; i++)
+	chosen[i] = FALSE;
+    for (i = 0; i < NumHottest; i++)
+    {
+	best = Hottest(opCounts, NumOpcodes, chosen);
+	if (best == -1)
+	    break;
+	OpName(best, name);
+	cout << " " << name << " (" << opCounts[best] << ")";
+    }
+    cout << "\n";
+    delete[] chosen;
+
+    numNodes = 0;
+    for (root = roots; root != NULL; root = root->sibling)
+	for (node = root; node != NULL; node = NextNode(node, root))
+	    numNodes++;
+    delete[] functionTotals;
+    functionTotals = new FunctionTotal[numNodes];
+    numFunctions = 0;
+    for (root = roots; root != NULL; root = root->sibling)
+	AddTotals(root);
+    qsort(functionTotals, numFunctions, sizeof(FunctionTotal), CompareTotals);
+    cout << "Hottest functions:";
+    for (i = 0; i < numFunctions && i < NumHottest; i++)
+    {
+	cout << " " << FunctionName(functionTotals[i].function);
+	cout << " (" << functionTotals[i].inclusive << "/";
+	cout << functionTotals[i].exclusive << ")";
+    }
+    cout << "\n";
+
+    file = fopen(fileName, "w");
+    if (file == NULL)
+    {
+	cerr << "Unable to write profile " << fileName << "\n";
+	return;
+    }
+    fprintf(file, "total instructions %d\n", total);
+    fprintf(file, "total loads %d\n", loads);
+    fprintf(file, "total stores %d\n", stores);
+    fprintf(file, "total taken %d\n", takenBranches);
+    for (i = 0; i < NumOpcodes; i++)
+	if (opCounts[i] > 0)
+	{
+	    OpName(i, name);
+	    fprintf(file, "op %s %d\n", name, opCounts[i]);
+	}
+    for (i = 0; i < numPCs; i++)
+	if (pcCounts[i] > 0)
+	{
+	    OpName(pcOps[i], name);
+	    fprintf(file, "pc %d %d %s\n", i * 4, pcCounts[i], name);
+	}
+    for (i = 0; i < numFunctions; i++)
+	fprintf(file, "func %s %d %d\n", FunctionName(functionTotals[i].function),
+		functionTotals[i].inclusive, functionTotals[i].exclusive);
+    fclose(file);
+
+    foldedName = new char[strlen(fileName) + strlen(".folded") + 1];
+    sprintf(foldedName, "%s.folded", fileName);
+    file = fopen(foldedName, "w");
+    if (file == NULL)
+	cerr << "Unable to write profile " << foldedName << "\n";
+    else
+    {
+	for (root = roots; root != NULL; root = root->sibling)
+	    WriteFolded(file, root);
+	fclose(file);
+    }
+    delete[] foldedName;
+}
@@ -0,0 +1,128 @@
+// profile.h
+//	Data structures for profiling user programs.
+//
+//	When Nachos is started with "-prof <file>", the simulator counts
+//	how often each user instruction (by virtual address) and each
+//	kind of instruction is executed, along with loads, stores and
+//	taken branches.  When Nachos halts, a short summary is printed,
+//	and the full counts are written to the file, one per line, so
+//	they can be sorted or plotted by other tools.
+//
+//	The simulator also follows calls (JAL, JALR) and returns (JR r31)
+//	to keep a shadow call stack for each user thread, and counts the
+//	instructions run in each calling context.  From these we get the
+//	time spent in each function, both in total (inclusive) and in its
+//	own code (exclusive), and "<file>.folded", a list of call stacks
+//	and their times in the folded format that flame graph tools read.
+//
+//	NOFF files carry no symbols, so functions are named by address,
+//	unless "-profsym <file>" gives a symbol table, in the format
+//	printed by nm for the program's COFF file.
+//
+//	Profiling is done by the instruction-at-a-time simulator; the
+//	block engine (-bb) is turned off while it is on.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "sysdep.h"
+
+const int NumOpcodes = 64;	// the OP_ codes in mipssim.h
+
+class FunctionTotal;
+class Symbol;
+
+// The following class defines a node in the calling context tree: a
+// function, as called through one particular chain of callers.
+
+class CallNode {
+  public:
+    CallNode(int function, CallNode *parent);
+				// a call to "function" from "parent"
+
+    CallNode *Child(int function);
+				// the node for a call from this one,
+				// added if this is the first such call
+
+    int function;		// the address of the function
+    CallNode *parent;		// the caller, or NULL for a thread's
+				// first function
+    CallNode *children;		// the functions called from here
+    CallNode *sibling;		// the next of our parent's children
+    int self;			// instructions run in the function itself
+};
+
+// The following class defines the counts kept while profiling.
+
+class Profile {
+  public:
+    Profile(char *fileName, char *symbolFile);
+				// start profiling; report to "fileName",
+				// naming functions from "symbolFile"
+				// (if it isn't NULL)
+    ~Profile();			// de-allocate the counts
+
+    void CountInstruction(int pc, int opCode, CallNode **context) {
+	opCounts[opCode]++;
+	if ((unsigned)pc / 4 >= (unsigned)numPCs)
+	    GrowPCs(pc);
+	pcCounts[(unsigned)pc / 4]++;
+	pcOps[(unsigned)pc / 4] = opCode;
+	if (*context == NULL)
+	    *context = Root(pc);
+	(*context)->self++;
+    }				// the instruction at "pc" is being run, by
+				// a thread whose place in the call graph is
+				// "*context" (NULL if it has just started)
+    void CountTaken() { takenBranches++; }
+				// the instruction just run was a jump, or
+				// a branch that was taken
+    void CountCall(int function, CallNode **context) {
+	*context = (*context)->Child(function);
+    }				// the instruction just run called "function"
+    void CountReturn(CallNode **context) {
+	if ((*context)->parent != NULL)
+	    *context = (*context)->parent;
+    }				// the instruction just run returned
+
+    void Print();		// print a summary, and write out the counts
+
+  private:
+    void GrowPCs(int pc);	// make room to count instructions at "pc"
+    CallNode *Root(int function);
+				// the node for a thread starting at
+				// "function"
+    void ReadSymbols(char *symbolFile);
+				// read the function names
+    char *FunctionName(int address);
+				// the name of the function at "address"
+    void AddTotals(CallNode *root);
+				// add a call graph to functionTotals
+    FunctionTotal *FindTotal(int function);
+				// the entry of functionTotals for "function"
+    void WriteFolded(FILE *file, CallNode *root);
+				// write out the call stacks in a graph
+
+    char *fileName;		// where to write the counts
+    int *pcCounts;		// times run, indexed by virtual address / 4
+    char *pcOps;		// OP_ code last seen at each address
+    int numPCs;			// size of pcCounts and pcOps
+    int opCounts[NumOpcodes];	// times run, indexed by OP_ code
+    int takenBranches;		// branches taken, and jumps
+
+    CallNode *roots;		// the bottom of each call stack, linked
+				// through "sibling"
+    Symbol *symbols;		// function names, sorted by address
+    int numSymbols;
+    FunctionTotal *functionTotals;
+				// time per function, computed by Print
+    int numFunctions;
+};
+
+#endif // PROFILE_H
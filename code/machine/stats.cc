@@ -10,6 +10,7 @@
 #include "copyright.h"
 #include "debug.h"
 #include "stats.h"
+#include "main.h"
 
 //----------------------------------------------------------------------
 // Statistics::Statistics
@@ -22,21 +23,31 @@ Statistics::Statistics()
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
-    tlbHitCnt = tlbVisitCnt = 0;
+    iCacheHits = iCacheMisses = dCacheHits = dCacheMisses = 0;
+    stallTicks = 0;
+    numJobs = numDeadlinesMissed = 0;
 }
 
 //----------------------------------------------------------------------
 // Statistics::Print
 // 	Print performance metrics, when we've finished everything
-//	at system shutdown.
+//	at system shutdown, and those of the TLB, if there is one.
 //----------------------------------------------------------------------
 
 void
 Statistics::Print()
 {
-	  cout<< "TLB Hit: "<<tlbHitCnt<<", Total Visit: "<<tlbVisitCnt<<", TLB Hit Rate: "<<(double)(100 * 1.0 * tlbHitCnt / tlbVisitCnt)<<"\n";
     cout << "Ticks: total " << totalTicks << ", idle " << idleTicks;
 		cout << ", system " << systemTicks << ", user " << userTicks <<"\n";
+    if (iCacheHits + iCacheMisses + dCacheHits + dCacheMisses > 0) {
+	cout << "Caches: instruction hits " << iCacheHits;
+	cout << ", misses " << iCacheMisses << "; data hits " << dCacheHits;
+	cout << ", misses " << dCacheMisses << "; stall ticks " << stallTicks << "\n";
+    }
+    if (numJobs > 0) {
+	cout << "Real time: jobs " << numJobs;
+	cout << ", deadlines missed " << numDeadlinesMissed << "\n";
+    }
     cout << "Disk I/O: reads " << numDiskReads;
 		cout << ", writes " << numDiskWrites << "\n";
 		cout << "Console I/O: reads " << numConsoleCharsRead;
@@ -44,4 +55,6 @@ Statistics::Print()
     cout << "Paging: faults " << numPageFaults << "\n";
     cout << "Network I/O: packets received " << numPacketsRecvd;
 		cout << ", sent " << numPacketsSent << "\n";
+    if (kernel->machine != NULL && kernel->machine->tlb != NULL)
+	kernel->machine->tlb->Print();
 }
@@ -36,7 +36,13 @@ class Statistics {
     int numPacketsSent;		// number of packets sent over the network
     int numPacketsRecvd;	// number of packets received over the network
 
-    int tlbVisitCnt,tlbHitCnt;
+    int iCacheHits, iCacheMisses;	// instruction fetches, and data
+    int dCacheHits, dCacheMisses;	// loads and stores, that hit and
+					// missed in the caches, if any
+    int stallTicks;		// user ticks spent waiting for misses
+				// (included in userTicks)
+    int numJobs;		// jobs released for real-time threads
+    int numDeadlinesMissed;	// jobs not done by their deadlines
 
     Statistics(); 		// initialize everything to zero
 
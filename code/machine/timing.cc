@@ -0,0 +1,152 @@
+// timing.cc
+//	Routines for charging user instructions by their opcodes (see
+//	timing.h).
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "machine.h"
+#include "timing.h"
+#include "mipssim.h"
+#include "main.h"
+
+// What an instruction does with its operands, for TimingModel::operands
+static const char ReadsRS = 0x1;	// reads register rs
+static const char ReadsRT = 0x2;	// reads register rt
+static const char Loads = 0x4;	// loads register rt from memory
+
+// The costs of a MIPS R3000, in ticks
+static const int MultiplyTicks = 12;
+static const int DivideTicks = 35;
+static const int LoadUseTicks = 1;
+static const int BranchTicks = 1;
+
+//----------------------------------------------------------------------
+// TimingModel::TimingModel
+// 	Set up the table of costs.
+//
+//	"costFile" -- changes to make to the MIPS costs, or NULL
+//----------------------------------------------------------------------
+
+TimingModel::TimingModel(char *costFile)
+{
+    costs = new int[MaxOpcode + 1];
+    operands = new char[MaxOpcode + 1];
+    for (int i = 0; i <= MaxOpcode; i++) {
+	costs[i] = UserTick;
+	operands[i] = ReadsRS;
+    }
+    costs[OP_MULT] = costs[OP_MULTU] = MultiplyTicks;
+    costs[OP_DIV] = costs[OP_DIVU] = DivideTicks;
+    loadUsePenalty = LoadUseTicks;
+    branchPenalty = BranchTicks;
+    loadReg = 0;
+
+    // instructions that don't read rs
+    operands[OP_J] = operands[OP_JAL] = operands[OP_LUI] = 0;
+    operands[OP_MFHI] = operands[OP_MFLO] = 0;
+    operands[OP_SLL] = operands[OP_SRA] = operands[OP_SRL] = ReadsRT;
+    operands[OP_SYSCALL] = operands[OP_RFE] = 0;
+    operands[OP_UNIMP] = operands[OP_RES] = 0;
+
+    // instructions that read rt as well
+    operands[OP_ADD] = operands[OP_ADDU] = operands[OP_SUB] =
+	operands[OP_SUBU] = ReadsRS | ReadsRT;
+    operands[OP_AND] = operands[OP_OR] = operands[OP_XOR] =
+	operands[OP_NOR] = ReadsRS | ReadsRT;
+    operands[OP_SLT] = operands[OP_SLTU] = ReadsRS | ReadsRT;
+    operands[OP_SLLV] = operands[OP_SRAV] = operands[OP_SRLV] =
+	ReadsRS | ReadsRT;
+    operands[OP_MULT] = operands[OP_MULTU] = operands[OP_DIV] =
+	operands[OP_DIVU] = ReadsRS | ReadsRT;
+    operands[OP_BEQ] = operands[OP_BNE] = ReadsRS | ReadsRT;
+    operands[OP_SB] = operands[OP_SH] = operands[OP_SW] =
+	operands[OP_SWL] = operands[OP_SWR] = ReadsRS | ReadsRT;
+
+    // loads; LWL and LWR merge into rt, so they read it too
+    operands[OP_LB] = operands[OP_LBU] = operands[OP_LH] =
+	operands[OP_LHU] = operands[OP_LW] = ReadsRS | Loads;
+    operands[OP_LWL] = operands[OP_LWR] = ReadsRS | ReadsRT | Loads;
+
+    if (costFile != NULL)
+	ReadCosts(costFile);
+}
+
+TimingModel::~TimingModel()
+{
+    delete[] costs;
+    delete[] operands;
+}
+
+//----------------------------------------------------------------------
+// TimingModel::ReadCosts
+// 	Change the costs listed in a file, one per line:
+//
+//		<opcode name> <ticks>
+//		loaduse <ticks>
+//		branch <ticks>
+//
+//	Opcode names are as in mipssim.h (eg, MULT, or LW), in either case.
+//----------------------------------------------------------------------
+
+void
+TimingModel::ReadCosts(char *costFile)
+{
+    FILE *file = fopen(costFile, "r");
+    char line[256], name[32], opName[32];
+    int ticks, i;
+
+    if (file == NULL)
+    {
+	cerr << "Unable to read costs " << costFile << "\n";
+	return;
+    }
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+	if (sscanf(line, "%31s %d", name, &ticks) != 2 || ticks < 0)
+	    continue;
+	if (strcasecmp(name, "loaduse") == 0) {
+	    loadUsePenalty = ticks;
+	    continue;
+	}
+	if (strcasecmp(name, "branch") == 0) {
+	    branchPenalty = ticks;
+	    continue;
+	}
+	for (i = 0; i <= MaxOpcode; i++)
+	{ // the name is the first word of the format in opStrings
+	    sscanf(opStrings[i].format, "%31s", opName);
+	    if (strcasecmp(name, opName) == 0)
+		break;
+	}
+	if (i > MaxOpcode)
+	    cerr << "Unknown opcode " << name << " in " << costFile << "\n";
+	else
+	    costs[i] = max(ticks, UserTick);
+    }
+    fclose(file);
+}
+
+//----------------------------------------------------------------------
+// TimingModel::Cost
+// 	Return the ticks, beyond the UserTick every instruction is charged,
+//	that an instruction takes to issue: what its opcode costs, and a
+//	stall if it uses the register the instruction before loaded.
+//
+//	"instr" -- the instruction about to be run
+//----------------------------------------------------------------------
+
+int
+TimingModel::Cost(Instruction *instr)
+{
+    int op = instr->opCode;
+    int ticks = costs[op] - UserTick;
+
+    if (loadReg != 0 && (((operands[op] & ReadsRS) && instr->rs == loadReg) ||
+			 ((operands[op] & ReadsRT) && instr->rt == loadReg)))
+	ticks += loadUsePenalty;
+    loadReg = (operands[op] & Loads) ? instr->rt : 0;
+    return ticks;
+}
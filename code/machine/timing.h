@@ -0,0 +1,65 @@
+// timing.h
+//	Data structures for charging user instructions by what they do.
+//
+//	By default every user instruction takes UserTick.  When Nachos is
+//	started with "-timing mips", each instruction is charged by its
+//	opcode instead, from a table of costs close to those of a MIPS
+//	R3000: multiplies and divides take many ticks, a load followed
+//	at once by an instruction using its result stalls, and so does a
+//	taken branch or jump.  "-timing <file>" starts from the same table
+//	and changes the entries listed in the file, one per line:
+//
+//		<opcode name, as in mipssim.h (eg, MULT)> <ticks>
+//		loaduse <ticks>		-- the load-use stall
+//		branch <ticks>		-- the taken branch penalty
+//
+//	The ticks beyond UserTick are charged after the instruction, as
+//	for cache misses (see Machine::Stall).
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TIMING_H
+#define TIMING_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "sysdep.h"
+
+class Instruction;
+
+// The following class defines the cost of each kind of instruction.
+
+class TimingModel {
+  public:
+    TimingModel(char *costFile);
+				// the MIPS costs, changed by "costFile"
+				// unless it is NULL
+    ~TimingModel();
+
+    int Cost(Instruction *instr);
+				// ticks beyond UserTick to charge for
+				// issuing "instr", after the instruction
+				// before it
+    int TakenCost() { return branchPenalty; }
+				// and more, if it turned out to be a taken
+				// branch or a jump
+    void Drain() { loadReg = 0; }
+				// forget the instruction before, when
+				// another thread's code runs next
+
+  private:
+    void ReadCosts(char *costFile);
+				// change the table
+
+    int *costs;			// ticks for each OP_ code
+    char *operands;		// which registers each one reads, and
+				// whether it loads (see timing.cc)
+    int loadUsePenalty;		// ticks to wait for a load
+    int branchPenalty;		// ticks for a taken branch or jump
+    int loadReg;		// the register the last instruction
+				// loaded, or 0 if it wasn't a load
+};
+
+#endif // TIMING_H
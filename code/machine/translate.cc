@@ -21,7 +21,9 @@
 //	anything at all about that.
 //
 //	Note that the contents of the TLB are specific to an address space.
-//	If the address space changes, so does the contents of the TLB!
+//	Each entry is tagged with the address space it belongs to (see
+//	class TLB), so they needn't be thrown away when the address
+//	space changes.
 //
 // DO NOT CHANGE -- part of the machine emulation
 //
@@ -32,6 +34,7 @@
 #include "copyright.h"
 #include "main.h"
 #include "stats.h"
+#include "memtrace.h"
 
 // Routines for converting Words and Short Words to and from the
 // simulated machine's format of little endian.  These end up
@@ -89,54 +92,66 @@ bool Machine::ReadMem(int addr, int size, int *value)
 	int data;
 	ExceptionType exception;
 	int physicalAddress;
+	char *host;
 
-	DEBUG(dbgAddr, "-----------------------\nReading VA " << addr << ", size " << size);
-
-	exception = Translate(addr, &physicalAddress, size, FALSE);
-	// if (exception != NoException)
-	// {
-	// 	RaiseException(exception, addr);
-	// 	return FALSE;
-	// }
-	if (exception != NoException)
+	host = QuickTranslate(addr, size, FALSE);
+	if (host == NULL)
 	{
-		RaiseException(exception, addr);
-		// 若发生缺页中断异常，处理异常后重新Translate
-		if (exception == PageFaultException)
+		DEBUG(dbgAddr, "-----------------------\nReading VA " << addr << ", size " << size);
+
+		exception = Translate(addr, &physicalAddress, size, FALSE);
+		// if (exception != NoException)
+		// {
+		// 	RaiseException(exception, addr);
+		// 	return FALSE;
+		// }
+		if (exception != NoException)
 		{
-			exception = Translate(addr, &physicalAddress, size, FALSE);
-			//再发生其他异常，由于无异常处理机制，直接返回
-			if (exception != NoException)
+			RaiseException(exception, addr);
+			// 若发生缺页中断异常，处理异常后重新Translate
+			if (exception == PageFaultException)
+			{
+				exception = Translate(addr, &physicalAddress, size, FALSE);
+				//再发生其他异常，由于无异常处理机制，直接返回
+				if (exception != NoException)
+				{
+					return FALSE;
+				}
+			}
+			else
 			{
 				return FALSE;
 			}
 		}
-		else
-		{
-			return FALSE;
-		}
+		FillSoftTLB(addr);
+		host = &mainMemory[physicalAddress];
 	}
 
 	switch (size)
 	{
 	case 1:
-		data = mainMemory[physicalAddress];
+		data = *host;
 		*value = data;
 		break;
 
 	case 2:
-		data = *(unsigned short *)&mainMemory[physicalAddress];
+		data = *(unsigned short *)host;
 		*value = ShortToHost(data);
 		break;
 
 	case 4:
-		data = *(unsigned int *)&mainMemory[physicalAddress];
+		data = *(unsigned int *)host;
 		*value = WordToHost(data);
 		break;
 
 	default:
 		ASSERT(FALSE);
 	}
+	if (kernel->memTrace != NULL)
+		kernel->memTrace->Record(TraceLoad, addr, host - mainMemory, size);
+	if (dCache != NULL)
+		UseCache(dCache, host - mainMemory, &kernel->stats->dCacheHits,
+				 &kernel->stats->dCacheMisses);
 
 	DEBUG(dbgAddr, "\tvalue read = " << *value);
 	return (TRUE);
@@ -159,50 +174,206 @@ bool Machine::WriteMem(int addr, int size, int value)
 {
 	ExceptionType exception;
 	int physicalAddress;
+	char *host;
 
-	DEBUG(dbgAddr, "Writing VA " << addr << ", size " << size << ", value " << value);
-
-	exception = Translate(addr, &physicalAddress, size, TRUE);
-	if (exception != NoException)
+	host = QuickTranslate(addr, size, TRUE);
+	if (host == NULL)
 	{
-		RaiseException(exception, addr);
-		// 若发生缺页中断异常，处理异常后重新Translate
-		if (exception == PageFaultException)
+		DEBUG(dbgAddr, "Writing VA " << addr << ", size " << size << ", value " << value);
+
+		exception = Translate(addr, &physicalAddress, size, TRUE);
+		if (exception != NoException)
 		{
-			exception = Translate(addr, &physicalAddress, size, FALSE);
-			//再发生其他异常，由于无异常处理机制，直接返回
-			if (exception != NoException)
+			RaiseException(exception, addr);
+			// 若发生缺页中断异常，处理异常后重新Translate
+			if (exception == PageFaultException)
+			{
+				exception = Translate(addr, &physicalAddress, size, FALSE);
+				//再发生其他异常，由于无异常处理机制，直接返回
+				if (exception != NoException)
+				{
+					return FALSE;
+				}
+			}
+			else
 			{
 				return FALSE;
 			}
+			// return FALSE;
 		}
-		else
-		{
-			return FALSE;
-		}
-		// return FALSE;	
+		FillSoftTLB(addr);
+		host = &mainMemory[physicalAddress];
 	}
 	switch (size)
 	{
 	case 1:
-		mainMemory[physicalAddress] = (unsigned char)(value & 0xff);
+		*host = (unsigned char)(value & 0xff);
 		break;
 
 	case 2:
-		*(unsigned short *)&mainMemory[physicalAddress] = ShortToMachine((unsigned short)(value & 0xffff));
+		*(unsigned short *)host = ShortToMachine((unsigned short)(value & 0xffff));
 		break;
 
 	case 4:
-		*(unsigned int *)&mainMemory[physicalAddress] = WordToMachine((unsigned int)value);
+		*(unsigned int *)host = WordToMachine((unsigned int)value);
 		break;
 
 	default:
 		ASSERT(FALSE);
 	}
+	InvalidateCode(host - mainMemory); // in case we overwrote an instruction
+	if (kernel->memTrace != NULL)
+		kernel->memTrace->Record(TraceStore, addr, host - mainMemory, size);
+	if (dCache != NULL)
+		UseCache(dCache, host - mainMemory, &kernel->stats->dCacheHits,
+				 &kernel->stats->dCacheMisses);
 
 	return TRUE;
 }
 
+//----------------------------------------------------------------------
+// Machine::UserPage
+//	Translate a virtual address for the kernel, which is about to
+//	copy data to or from the rest of its page.  As in ReadMem and
+//	WriteMem, a page fault is handled and the translation retried.
+//
+//	Returns a pointer into mainMemory, or NULL if the address can't
+//	be translated.
+//
+//	"virtAddr" -- the virtual address to translate
+//	"writing" -- TRUE if the kernel is going to write to the page
+//----------------------------------------------------------------------
+
+char *
+Machine::UserPage(int virtAddr, bool writing)
+{
+	ExceptionType exception;
+	int physicalAddress;
+	char *host;
+
+	host = QuickTranslate(virtAddr, 1, writing);
+	if (host != NULL)
+		return host;
+
+	exception = Translate(virtAddr, &physicalAddress, 1, writing);
+	if (exception != NoException)
+	{
+		RaiseException(exception, virtAddr);
+		if (exception != PageFaultException)
+			return NULL;
+		if (Translate(virtAddr, &physicalAddress, 1, writing) != NoException)
+			return NULL;
+	}
+	FillSoftTLB(virtAddr);
+	return &mainMemory[physicalAddress];
+}
+
+//----------------------------------------------------------------------
+// Machine::CopyIn
+//	Copy "count" bytes of user memory, starting at virtual address
+//	"virtAddr", into the kernel buffer "into".  Each page is
+//	translated once, and copied all at once.
+//
+//	Returns the number of bytes copied, which is less than "count"
+//	only if some address couldn't be translated.
+//----------------------------------------------------------------------
+
+int Machine::CopyIn(int virtAddr, char *into, int count)
+{
+	int done = 0;
+	int numBytes;
+	char *host;
+
+	DEBUG(dbgAddr, "Copying in " << count << " bytes from VA " << virtAddr);
+
+	while (done < count)
+	{
+		host = UserPage(virtAddr + done, FALSE);
+		if (host == NULL)
+			break;
+		numBytes = min(count - done, PageSize - (int)((unsigned)(virtAddr + done) % PageSize));
+		bcopy(host, into + done, numBytes);
+		done += numBytes;
+	}
+	return done;
+}
+
+//----------------------------------------------------------------------
+// Machine::CopyOut
+//	Copy "count" bytes from the kernel buffer "from" into user memory,
+//	starting at virtual address "virtAddr".  Each page is translated
+//	once, and copied all at once.
+//
+//	Returns the number of bytes copied, which is less than "count"
+//	only if some address couldn't be translated (or was read-only).
+//----------------------------------------------------------------------
+
+int Machine::CopyOut(int virtAddr, char *from, int count)
+{
+	int done = 0;
+	int numBytes;
+	int physAddr;
+	char *host;
+
+	DEBUG(dbgAddr, "Copying out " << count << " bytes to VA " << virtAddr);
+
+	while (done < count)
+	{
+		host = UserPage(virtAddr + done, TRUE);
+		if (host == NULL)
+			break;
+		numBytes = min(count - done, PageSize - (int)((unsigned)(virtAddr + done) % PageSize));
+		bcopy(from + done, host, numBytes);
+		for (physAddr = (host - mainMemory) & ~3; physAddr < (host - mainMemory) + numBytes; physAddr += 4)
+			InvalidateCode(physAddr); // in case we overwrote an instruction
+		done += numBytes;
+	}
+	return done;
+}
+
+//----------------------------------------------------------------------
+// Machine::StringIn
+//	Copy a null-terminated string out of user memory, starting at
+//	virtual address "virtAddr", into the kernel buffer "into", which
+//	has room for "size" bytes.  A string that doesn't fit is cut
+//	short; "into" is always null-terminated.
+//
+//	Returns the length of the string copied, or -1 if some address
+//	couldn't be translated.
+//----------------------------------------------------------------------
+
+int Machine::StringIn(int virtAddr, char *into, int size)
+{
+	int done = 0;
+	int numBytes;
+	char *host;
+	char *end;
+
+	ASSERT(size > 0);
+	DEBUG(dbgAddr, "Copying in a string from VA " << virtAddr);
+
+	while (done < size - 1)
+	{
+		host = UserPage(virtAddr + done, FALSE);
+		if (host == NULL)
+		{
+			into[done] = '\0';
+			return -1;
+		}
+		numBytes = min(size - 1 - done, PageSize - (int)((unsigned)(virtAddr + done) % PageSize));
+		end = (char *)memchr(host, '\0', numBytes);
+		if (end != NULL)
+		{ // found the end of the string
+			bcopy(host, into + done, end - host + 1);
+			return done + (end - host);
+		}
+		bcopy(host, into + done, numBytes);
+		done += numBytes;
+	}
+	into[done] = '\0';
+	return done;
+}
+
 //----------------------------------------------------------------------
 // Machine::Translate
 // 	Translate a virtual address into a physical address, using
@@ -221,7 +392,6 @@ bool Machine::WriteMem(int addr, int size, int value)
 ExceptionType
 Machine::Translate(int virtAddr, int *physAddr, int size, bool writing)
 {
-	int i;
 	unsigned int vpn, offset;
 	TranslationEntry *entry;
 	unsigned int pageFrame;
@@ -259,16 +429,8 @@ Machine::Translate(int virtAddr, int *physAddr, int size, bool writing)
 		entry = &pageTable[vpn];
 	}
 	else
-	{	
-		kernel->stats->tlbVisitCnt++;
-		for (entry = NULL, i = 0; i < TLBSize; i++)
-			if (tlb[i].valid && (tlb[i].virtualPage == ((int)vpn)))
-			{
-				entry = &tlb[i]; // FOUND!
-				kernel->stats->tlbHitCnt++;
-				tlb[i].lastVisitedTime = kernel->stats->totalTicks; // 更新tlb的lastVisitedTime值 lru
-				break;
-			}
+	{
+		entry = tlb->Lookup(spaceId, vpn);
 		if (entry == NULL)
 		{ // not found
 			DEBUG(dbgAddr, "Invalid TLB entry for this virtual page!");
@@ -287,7 +449,7 @@ Machine::Translate(int virtAddr, int *physAddr, int size, bool writing)
 
 	// if the pageFrame is too big, there is something really wrong!
 	// An invalid translation was loaded into the page table or TLB.
-	if (pageFrame >= NumPhysPages)
+	if (pageFrame >= (unsigned int)NumPhysPages)
 	{
 		DEBUG(dbgAddr, "Illegal pageframe " << pageFrame);
 		return BusErrorException;
@@ -300,3 +462,397 @@ Machine::Translate(int virtAddr, int *physAddr, int size, bool writing)
 	DEBUG(dbgAddr, "phys addr = " << *physAddr);
 	return NoException;
 }
+
+//----------------------------------------------------------------------
+// Machine::QuickTranslate
+// 	Look up a virtual address in the soft TLB: a small direct-mapped
+//	cache, kept by the simulator, of translations that have recently
+//	succeeded.  It isn't part of the simulated hardware, so a hit has
+//	to leave behind everything Translate would have: the statistics
+//	and replacement state of the (simulated) TLB, and the use and
+//	dirty bits.
+//
+//	Returns a pointer into mainMemory, or NULL if the address isn't
+//	in the soft TLB (or is misaligned, or is a write to a read-only
+//	page), in which case the caller has to call Translate.
+//
+//	"virtAddr" -- the virtual address to translate
+//	"size" -- the amount of memory being read or written
+// 	"writing" -- if TRUE, the page must be writable
+//----------------------------------------------------------------------
+
+char *
+Machine::QuickTranslate(int virtAddr, int size, bool writing)
+{
+	unsigned int vpn = (unsigned)virtAddr >> PageShift;
+	SoftTLBEntry *soft = &softTLB[vpn % SoftTLBSize];
+
+	if (soft->generation != softTLBGeneration || soft->virtualPage != vpn ||
+		(virtAddr & (size - 1)) != 0 || (writing && !soft->writable))
+		return NULL;
+
+	if (tlb != NULL)
+		tlb->Reference(soft->entry);
+	soft->entry->use = TRUE;
+	if (writing)
+		soft->entry->dirty = TRUE;
+	return soft->host + ((unsigned)virtAddr & (PageSize - 1));
+}
+
+//----------------------------------------------------------------------
+// Machine::FillSoftTLB
+// 	Remember the translation of a virtual address, which Translate
+//	has just done successfully, in the soft TLB.
+//
+//	Nothing is remembered while address translation is being traced,
+//	so that every access still shows up in the trace.
+//
+//	"virtAddr" -- the virtual address that was translated
+//----------------------------------------------------------------------
+
+void Machine::FillSoftTLB(int virtAddr)
+{
+	unsigned int vpn = (unsigned)virtAddr / PageSize;
+	SoftTLBEntry *soft = &softTLB[vpn % SoftTLBSize];
+	TranslationEntry *entry = NULL;
+
+	if (debug->IsEnabled(dbgAddr))
+		return;
+
+	if (tlb == NULL)
+		entry = &pageTable[vpn];
+	else // the same entry Translate found
+		entry = tlb->Find(spaceId, vpn);
+	if (entry == NULL)
+		return;
+
+	soft->virtualPage = vpn;
+	soft->generation = softTLBGeneration;
+	soft->host = &mainMemory[entry->physicalPage * PageSize];
+	soft->writable = !entry->readOnly;
+	soft->entry = entry;
+}
+
+//----------------------------------------------------------------------
+// Machine::FlushSoftTLB
+// 	Forget every translation in the soft TLB.  Must be called whenever
+//	the page table or the TLB might have changed; the simulator does
+//	this itself after every exception and interrupt, and when
+//	AddrSpace::RestoreState switches page tables.
+//----------------------------------------------------------------------
+
+void Machine::FlushSoftTLB()
+{
+	softTLBGeneration++;
+	if (softTLBGeneration == 0)
+	{ // wrapped around; make sure no entry looks valid
+		for (int i = 0; i < SoftTLBSize; i++)
+			softTLB[i].generation = 0;
+		softTLBGeneration = 1;
+	}
+}
+
+// The names of the replacement policies, as given to -tlbpolicy
+static const char *policyNames[NumTLBPolicies] = {
+	"fifo", "lru", "nru", "clock", "random"
+};
+
+// How many references NRU waits between clearing the use bits
+static const int NRUPeriod = 100;
+
+//----------------------------------------------------------------------
+// TLB::TLB
+// 	Initialize an empty TLB, replacing entries first-in first-out
+//	until told otherwise.
+//
+//	"numEntries" -- the number of translations it holds
+//	"ways" -- the number of entries in each set; must divide numEntries
+//----------------------------------------------------------------------
+
+TLB::TLB(int numEntries, int ways)
+{
+	ASSERT(ways > 0 && numEntries % ways == 0);
+
+	this->numEntries = numEntries;
+	this->ways = ways;
+	numSets = numEntries / ways;
+	entries = new TranslationEntry[numEntries];
+	spaces = new int[numEntries];
+	loadedAt = new unsigned int[numEntries];
+	usedAt = new unsigned int[numEntries];
+	hands = new int[numSets];
+	for (int i = 0; i < numEntries; i++)
+	{
+		entries[i].valid = FALSE;
+		spaces[i] = -1;
+		loadedAt[i] = usedAt[i] = 0;
+	}
+	for (int i = 0; i < numSets; i++)
+		hands[i] = 0;
+	policy = TLBFifo;
+	references = 0;
+	hits = misses = evictions = 0;
+}
+
+TLB::~TLB()
+{
+	delete[] entries;
+	delete[] spaces;
+	delete[] loadedAt;
+	delete[] usedAt;
+	delete[] hands;
+}
+
+//----------------------------------------------------------------------
+// TLB::Find
+// 	Return the entry translating a virtual page of an address space,
+//	or NULL if it isn't in the TLB.  Only the page's set is searched.
+//
+//	"space" -- the ASID of the address space
+//	"virtualPage" -- the page to translate
+//----------------------------------------------------------------------
+
+TranslationEntry *
+TLB::Find(int space, int virtualPage)
+{
+	int first = ((unsigned)virtualPage % numSets) * ways;
+
+	for (int i = first; i < first + ways; i++)
+		if (entries[i].valid && entries[i].virtualPage == virtualPage &&
+			spaces[i] == space)
+			return &entries[i];
+	return NULL;
+}
+
+//----------------------------------------------------------------------
+// TLB::Lookup
+// 	Like Find, but count the reference as a hit or a miss, and
+//	remember that the entry was used.
+//----------------------------------------------------------------------
+
+TranslationEntry *
+TLB::Lookup(int space, int virtualPage)
+{
+	TranslationEntry *entry = Find(space, virtualPage);
+
+	if (entry != NULL)
+		Reference(entry);
+	else
+	{
+		misses++;
+		references++;
+	}
+	return entry;
+}
+
+//----------------------------------------------------------------------
+// TLB::Reference
+// 	Count a hit on an entry, and remember when it was used.  Every
+//	so often, NRU forgets which entries have been used.
+//
+//	"entry" -- the entry used; one of ours
+//----------------------------------------------------------------------
+
+void TLB::Reference(TranslationEntry *entry)
+{
+	hits++;
+	usedAt[entry - entries] = ++references;
+	if (policy == TLBNru && references % NRUPeriod == 0)
+		ClearUseBits();
+}
+
+//----------------------------------------------------------------------
+// TLB::Load
+// 	Copy a translation into the TLB.  If its set has no free entry,
+//	the replacement policy picks one to give up.
+//
+//	Returns the new entry.
+//
+//	"space" -- the ASID of the address space the translation is for
+//	"entry" -- the translation, usually from a page table
+//----------------------------------------------------------------------
+
+TranslationEntry *
+TLB::Load(int space, TranslationEntry *entry)
+{
+	int set = (unsigned)entry->virtualPage % numSets;
+	int victim = Victim(set);
+
+	if (entries[victim].valid)
+	{
+		DEBUG(dbgAddr, "TLB replaces page " << entries[victim].virtualPage
+				<< " of space " << spaces[victim] << " with page "
+				<< entry->virtualPage << " of space " << space);
+		evictions++;
+	}
+	entries[victim] = *entry;
+	spaces[victim] = space;
+	loadedAt[victim] = usedAt[victim] = references;
+	return &entries[victim];
+}
+
+//----------------------------------------------------------------------
+// TLB::Victim
+// 	Return the index of the entry of a set to load a translation
+//	into: a free one if there is one, otherwise the one chosen by
+//	the replacement policy.
+//
+//	"set" -- the number of the set
+//----------------------------------------------------------------------
+
+int TLB::Victim(int set)
+{
+	int first = set * ways;
+	int victim = first;
+	int i;
+
+	for (i = first; i < first + ways; i++)
+		if (!entries[i].valid)
+			return i;
+
+	switch (policy)
+	{
+	case TLBFifo:
+		for (i = first; i < first + ways; i++)
+			if (loadedAt[i] < loadedAt[victim])
+				victim = i;
+		break;
+	case TLBLru:
+		for (i = first; i < first + ways; i++)
+			if (usedAt[i] < usedAt[victim])
+				victim = i;
+		break;
+	case TLBNru:
+		// the first entry of the lowest class: (use, dirty) =
+		// (0, 0), then (0, 1), (1, 0), and (1, 1)
+		for (i = first; i < first + ways; i++)
+			if (entries[i].use * 2 + entries[i].dirty <
+				entries[victim].use * 2 + entries[victim].dirty)
+				victim = i;
+		break;
+	case TLBClock:
+		// give each used entry a second chance, clearing its use
+		// bit as we go past; we stop within one trip round the set
+		for (;;)
+		{
+			victim = first + hands[set];
+			hands[set] = (hands[set] + 1) % ways;
+			if (!entries[victim].use)
+				break;
+			entries[victim].use = FALSE;
+		}
+		break;
+	case TLBRandom:
+		victim = first + RandomNumber() % ways;
+		break;
+	default:
+		ASSERTNOTREACHED();
+	}
+	return victim;
+}
+
+//----------------------------------------------------------------------
+// TLB::ClearUseBits
+// 	Clear the use bit of every entry, so that NRU can tell which
+//	entries have been used since.
+//----------------------------------------------------------------------
+
+void TLB::ClearUseBits()
+{
+	for (int i = 0; i < numEntries; i++)
+		entries[i].use = FALSE;
+}
+
+//----------------------------------------------------------------------
+// TLB::FlushSpace
+// 	Invalidate every entry belonging to an address space, when it
+//	goes away, so its ASID can be used again.
+//
+//	"space" -- the ASID of the address space
+//----------------------------------------------------------------------
+
+void TLB::FlushSpace(int space)
+{
+	for (int i = 0; i < numEntries; i++)
+		if (spaces[i] == space)
+			entries[i].valid = FALSE;
+}
+
+//----------------------------------------------------------------------
+// TLB::PolicyNamed
+// 	Return the replacement policy with the given name.  Stop if
+//	there is no such policy.
+//
+//	"name" -- one of "fifo", "lru", "nru", "clock" or "random"
+//----------------------------------------------------------------------
+
+TLBPolicy
+TLB::PolicyNamed(char *name)
+{
+	for (int i = 0; i < NumTLBPolicies; i++)
+		if (strcmp(name, policyNames[i]) == 0)
+			return (TLBPolicy)i;
+	cerr << "Unknown TLB replacement policy " << name << "\n";
+	ASSERTNOTREACHED();
+	return TLBFifo;
+}
+
+//----------------------------------------------------------------------
+// TLB::Print
+// 	Print how well the TLB did, so that runs of the same program with
+//	different sizes and policies can be compared.
+//----------------------------------------------------------------------
+
+void TLB::Print()
+{
+	int lookups = hits + misses;
+
+	cout << "TLB: " << numEntries << " entries, " << ways << "-way, "
+		 << policyNames[policy] << " replacement\n";
+	cout << "TLB: hits " << hits << ", misses " << misses;
+	if (lookups > 0)
+		cout << " (" << (100.0 * misses / lookups) << "%)";
+	cout << ", evictions " << evictions << "\n";
+}
+
+//----------------------------------------------------------------------
+// TLB::WriteSnapshot
+// 	Save the entries, their tags and their replacement state to a
+//	snapshot file.
+//
+//	"fd" -- the snapshot file
+//----------------------------------------------------------------------
+
+void TLB::WriteSnapshot(int fd)
+{
+	WriteFile(fd, (char *)entries, numEntries * sizeof(TranslationEntry));
+	WriteFile(fd, (char *)spaces, numEntries * sizeof(int));
+	WriteFile(fd, (char *)loadedAt, numEntries * sizeof(unsigned int));
+	WriteFile(fd, (char *)usedAt, numEntries * sizeof(unsigned int));
+	WriteFile(fd, (char *)hands, numSets * sizeof(int));
+	WriteFile(fd, (char *)&references, sizeof(references));
+	WriteFile(fd, (char *)&hits, sizeof(hits));
+	WriteFile(fd, (char *)&misses, sizeof(misses));
+	WriteFile(fd, (char *)&evictions, sizeof(evictions));
+}
+
+//----------------------------------------------------------------------
+// TLB::ReadSnapshot
+// 	Restore what WriteSnapshot saved.  The caller has checked that
+//	the snapshot was taken with a TLB of the same shape.
+//
+//	"fd" -- the snapshot file
+//----------------------------------------------------------------------
+
+void TLB::ReadSnapshot(int fd)
+{
+	Read(fd, (char *)entries, numEntries * sizeof(TranslationEntry));
+	Read(fd, (char *)spaces, numEntries * sizeof(int));
+	Read(fd, (char *)loadedAt, numEntries * sizeof(unsigned int));
+	Read(fd, (char *)usedAt, numEntries * sizeof(unsigned int));
+	Read(fd, (char *)hands, numSets * sizeof(int));
+	Read(fd, (char *)&references, sizeof(references));
+	Read(fd, (char *)&hits, sizeof(hits));
+	Read(fd, (char *)&misses, sizeof(misses));
+	Read(fd, (char *)&evictions, sizeof(evictions));
+}
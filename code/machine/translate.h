@@ -40,7 +40,77 @@ class TranslationEntry {
 			// page is referenced or modified.
     bool dirty;         // This bit is set by the hardware every time the
 			// page is modified.
-    int lastVisitedTime; //添加一个新的成员变量 保存最近访问时间
+};
+
+// The ways the TLB can choose which entry of a set to replace, when a
+// new translation is loaded into a full set.
+
+enum TLBPolicy { TLBFifo,	// the entry loaded longest ago
+		 TLBLru,	// the entry used longest ago
+		 TLBNru,	// an entry not used recently (by its use and
+				// dirty bits, which are cleared periodically)
+		 TLBClock,	// the next entry, going round the set, that
+				// hasn't been used since we last came by
+		 TLBRandom,	// any entry
+		 NumTLBPolicies
+};
+
+// The following class defines a set-associative translation lookaside
+// buffer.  Each entry is tagged with the address space it belongs to
+// (its ASID), so the kernel doesn't have to flush the TLB when it
+// switches address spaces; an address space's entries just stop
+// matching until it runs again.
+//
+// The TLB is split into sets of "ways" entries each; a virtual page can
+// only be loaded into the set numbered (page % number of sets).  With
+// one set, the TLB is fully associative.
+
+class TLB {
+  public:
+    TLB(int numEntries, int ways);	// an empty TLB, "numEntries" big
+    ~TLB();
+
+    TranslationEntry *Lookup(int space, int virtualPage);
+				// The entry translating "virtualPage" in
+				// address space "space", or NULL if there
+				// is none; counts as a reference.
+    TranslationEntry *Find(int space, int virtualPage);
+				// The same, but without counting it
+    void Reference(TranslationEntry *entry);
+				// Count a hit on "entry", which was found
+				// without going through Lookup
+
+    TranslationEntry *Load(int space, TranslationEntry *entry);
+				// Copy a translation into the TLB, replacing
+				// an entry of its set if the set is full
+    void FlushSpace(int space);	// Forget an address space's entries
+
+    void SetPolicy(TLBPolicy which) { policy = which; }
+    static TLBPolicy PolicyNamed(char *name);
+				// "fifo", "lru", "nru", "clock" or "random"
+
+    void Print();		// print the hit and miss counts
+
+    void WriteSnapshot(int fd);	// Save or restore the entries and their
+    void ReadSnapshot(int fd);	// replacement state
+
+  private:
+    int Victim(int set);	// the entry of "set" to replace next
+    void ClearUseBits();	// forget which entries were used (for NRU)
+
+    TranslationEntry *entries;	// numEntries translations, set by set
+    int *spaces;		// the address space of each entry
+    unsigned int *loadedAt;	// when each entry was loaded, and last
+    unsigned int *usedAt;	// used, counted in references
+    int *hands;			// where the clock is, in each set
+    int numEntries;
+    int ways;			// entries per set
+    int numSets;
+    TLBPolicy policy;		// how to pick the entry to replace
+
+    unsigned int references;	// lookups and hits so far
+    int hits, misses;		// how lookups turned out
+    int evictions;		// valid entries replaced by Load
 };
 
 #endif
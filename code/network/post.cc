@@ -120,8 +120,10 @@ void
 MailBox::Get(PacketHeader *pktHdr, MailHeader *mailHdr, char *data) 
 { 
     DEBUG(dbgNet, "Waiting for mail in mailbox");
+    kernel->currentThread->waitingForIO = TRUE;
     Mail *mail = messages->RemoveFront();	// remove message from list;
 						// will wait if list is empty
+    kernel->currentThread->waitingForIO = FALSE;
 
     *pktHdr = mail->pktHdr;
     *mailHdr = mail->mailHdr;
@@ -39,8 +39,10 @@ Alarm::Alarm(bool doRandom)
 //	if the interrupted thread called Yield at the point it is 
 //	was interrupted.
 //
-//	For now, just provide time-slicing.  Only need to time slice 
-//      if we're currently running something (in other words, not idle).
+//	For now, just provide time-slicing.  The scheduler decides whether
+//	the running thread has had its turn (for the default scheduler,
+//	it always has).  Only need to time slice if we're currently
+//	running something (in other words, not idle).
 //----------------------------------------------------------------------
 
 void 
@@ -48,8 +50,9 @@ Alarm::CallBack()
 {
     Interrupt *interrupt = kernel->interrupt;
     MachineStatus status = interrupt->getStatus();
+    bool preempt = kernel->scheduler->TimerTick();
     
-    if (status != IdleMode) {
+    if (status != IdleMode && preempt) {
 	interrupt->YieldOnReturn();
     }
 }
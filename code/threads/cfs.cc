@@ -0,0 +1,315 @@
+// cfs.cc
+//	Routines for the completely fair scheduler (see cfs.h).
+//
+// 	These routines assume that interrupts are already disabled, as
+//	for the Scheduler.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "debug.h"
+#include "cfs.h"
+#include "main.h"
+#include "synch.h"
+
+//----------------------------------------------------------------------
+// VruntimeCompare
+//	Compare two threads by how much virtual runtime they have had.
+//----------------------------------------------------------------------
+
+static int
+VruntimeCompare(Thread *x, Thread *y)
+{
+    if (x->vruntime < y->vruntime)
+    {
+        return -1;
+    }
+    else if (x->vruntime > y->vruntime)
+    {
+        return 1;
+    }
+    else
+    {
+        return 0;
+    }
+}
+
+//----------------------------------------------------------------------
+// TenantKey, TenantHash
+//	Find a tenant in the hash table of tenants, by its uid.
+//----------------------------------------------------------------------
+
+static int
+TenantKey(CFSTenant *tenant)
+{
+    return tenant->uid;
+}
+
+static unsigned int
+TenantHash(int uid)
+{
+    return (unsigned int)uid;
+}
+
+//----------------------------------------------------------------------
+// Shares
+//	Return the number of shares of the CPU a thread has, for its
+//	priority.
+//----------------------------------------------------------------------
+
+static int
+Shares(Thread *thread)
+{
+    return thread->getPriority() + 1;
+}
+
+//----------------------------------------------------------------------
+// CFSScheduler::CFSScheduler
+// 	Initialize the scheduler, with no ready threads.
+//----------------------------------------------------------------------
+
+CFSScheduler::CFSScheduler()
+{
+    ready = new Heap<Thread *>(VruntimeCompare);
+    tenants = new HashTable<int, CFSTenant *>(TenantKey, TenantHash);
+    minVruntime = 0;
+}
+
+//----------------------------------------------------------------------
+// CFSScheduler::~CFSScheduler
+// 	De-allocate the heap of ready threads, and the tenants.
+//----------------------------------------------------------------------
+
+CFSScheduler::~CFSScheduler()
+{
+    while (!tenants->IsEmpty())
+    {
+        HashIterator<int, CFSTenant *> iter(tenants);
+
+        delete tenants->Remove(iter.Item()->uid);
+    }
+    delete tenants;
+    delete ready;
+}
+
+//----------------------------------------------------------------------
+// CFSScheduler::Tenant
+// 	Return the tenant for a uid, making a new one if this is the
+//	first thread of that uid to run.
+//
+//	"uid" is the uid
+//----------------------------------------------------------------------
+
+CFSTenant *
+CFSScheduler::Tenant(int uid)
+{
+    CFSTenant *tenant;
+
+    if (!tenants->Find(uid, &tenant))
+    {
+        tenant = new CFSTenant;
+        tenant->uid = uid;
+        tenant->readyShares = 0;
+        tenants->Insert(tenant);
+    }
+    return tenant;
+}
+
+//----------------------------------------------------------------------
+// CFSScheduler::ReadyToRun
+// 	Mark a thread as ready, and put it in the heap.  A thread that
+//	has been blocked for a while has fallen behind the others; it
+//	is brought up to no more than CFSLatency / 2 behind, so that
+//	it doesn't shut them out while it catches up.
+//
+//	"thread" is the thread to be put on the ready list.
+//----------------------------------------------------------------------
+
+void CFSScheduler::ReadyToRun(Thread *thread)
+{
+    double credit = CFSLatency / 2;
+
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    DEBUG(dbgThread, "Putting thread on ready list: " << thread->getName());
+
+    if (thread->vruntime < minVruntime - credit)
+    {
+        thread->vruntime = minVruntime - credit;
+    }
+    thread->schedTicks = 0; // a new turn, when it next runs
+    thread->setStatus(READY);
+    Tenant(thread->getUid())->readyShares += Shares(thread);
+    ready->Insert(thread);
+}
+
+//----------------------------------------------------------------------
+// CFSScheduler::FindNextToRun
+// 	Return the ready thread that has had the least virtual runtime,
+//	or NULL if there are no ready threads.
+// Side effect:
+//	Thread is removed from the heap.
+//----------------------------------------------------------------------
+
+Thread *
+CFSScheduler::FindNextToRun()
+{
+    Thread *thread;
+
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+
+    if (ready->IsEmpty())
+    {
+        return NULL;
+    }
+    thread = ready->RemoveFront();
+    Tenant(thread->getUid())->readyShares -= Shares(thread);
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// CFSScheduler::Charge
+// 	Add the time a thread has just run to its virtual runtime,
+//	scaled by its part of its tenant's share of the CPU: its own
+//	shares, out of those of all of the tenant's runnable threads.
+//	Then move up the least virtual runtime, if all the threads have
+//	moved past it.
+//
+//	"thread" is the thread that ran
+//	"ticks" is how long it ran
+//----------------------------------------------------------------------
+
+void CFSScheduler::Charge(Thread *thread, int ticks)
+{
+    int tenantShares;
+    double least;
+
+    if (ticks == 0)
+    {
+        return;
+    }
+    // the thread isn't in the heap, so add its shares to those of
+    // the tenant's ready threads
+    tenantShares = Tenant(thread->getUid())->readyShares + Shares(thread);
+    thread->vruntime += (double)ticks * tenantShares / Shares(thread);
+    thread->schedTicks += ticks;
+
+    least = thread->vruntime;
+    if (!ready->IsEmpty() && ready->Front()->vruntime < least)
+    {
+        least = ready->Front()->vruntime;
+    }
+    if (least > minVruntime)
+    {
+        minVruntime = least;
+    }
+}
+
+//----------------------------------------------------------------------
+// CFSScheduler::Slice
+// 	Return how long the running thread may run before it is
+//	preempted: CFSLatency shared among the runnable threads, or
+//	CFSMinSlice if that's longer.
+//----------------------------------------------------------------------
+
+int CFSScheduler::Slice()
+{
+    int slice = CFSLatency / (ready->NumInHeap() + 1);
+
+    return (slice < CFSMinSlice) ? CFSMinSlice : slice;
+}
+
+//----------------------------------------------------------------------
+// CFSScheduler::TimerTick
+// 	Called on each timer interrupt.  Charge the running thread for
+//	the time it has run, and preempt it if it has had its slice and
+//	another thread is now further behind.
+//----------------------------------------------------------------------
+
+bool CFSScheduler::TimerTick()
+{
+    Thread *thread = kernel->currentThread;
+
+    Account();
+    if (ready->IsEmpty())
+    {
+        return FALSE;
+    }
+    return thread->schedTicks >= Slice() &&
+           ready->Front()->vruntime < thread->vruntime;
+}
+
+//----------------------------------------------------------------------
+// CFSScheduler::Print
+// 	Print the ready threads, by virtual runtime, for debugging.
+//----------------------------------------------------------------------
+
+static void
+VruntimePrint(Thread *thread)
+{
+    cout << thread->vruntime << ": ";
+    thread->Print();
+}
+
+void CFSScheduler::Print()
+{
+    cout << "Ready list contents (least virtual runtime is " << minVruntime << "):\n";
+    ready->Apply(VruntimePrint);
+}
+
+//----------------------------------------------------------------------
+// CFSSpinner
+// 	Keep the CPU busy until the CFS self test is over, counting how
+//	much of it we got.
+//----------------------------------------------------------------------
+
+static int cfsEnd;		// when the test is over
+static Semaphore *cfsDone;	// V'd by each spinner when it is done
+
+static void
+CFSSpinner(int *spins)
+{
+    while (kernel->stats->totalTicks < cfsEnd)
+    {
+        Scheduler::Spin(SystemTick);
+        (*spins)++;
+    }
+    cfsDone->V();
+}
+
+//----------------------------------------------------------------------
+// CFSScheduler::SelfTest
+// 	Run one CPU-bound thread for one uid against three for another,
+//	all of the same priority, and check that the two uids get about
+//	the same CPU: a tenant can't get more by running more threads.
+//----------------------------------------------------------------------
+
+void CFSScheduler::SelfTest()
+{
+    const int uids = 2;
+    const int threads[uids] = { 1, 3 };	// spinners of each uid
+    int spins[uids] = { 0, 0 };
+    int count = 0;
+
+    cfsEnd = kernel->stats->totalTicks + 20 * CFSLatency;
+    cfsDone = new Semaphore("cfs done", 0);
+    for (int i = 0; i < uids; i++)
+    {
+        for (int j = 0; j < threads[i]; j++, count++)
+        {
+            Thread *t = new Thread("cfs spinner", 0, i + 1);
+
+            t->Fork((VoidFunctionPtr)CFSSpinner, (void *)&spins[i]);
+        }
+    }
+    while (count-- > 0)
+    {
+        cfsDone->P();
+    }
+    delete cfsDone;
+
+    DEBUG(dbgThread, "CFS self test: uid 1 spun " << spins[0] << ", uid 2 spun " << spins[1]);
+    ASSERT(spins[0] > 0 && spins[1] > 0);
+    ASSERT(10 * abs(spins[0] - spins[1]) <= spins[0] + spins[1]);
+}
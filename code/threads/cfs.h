@@ -0,0 +1,95 @@
+// cfs.h
+//	Data structures for a completely fair scheduler.
+//
+//	Rather than always running the thread of highest priority, the
+//	scheduler shares out the CPU in proportion to weights:
+//
+//	   Each thread keeps a "virtual runtime": the ticks it has run,
+//	   scaled down by its weight.  The scheduler always runs the
+//	   ready thread with the least virtual runtime, so over time,
+//	   each thread gets a share of the CPU in proportion to its
+//	   weight.
+//
+//	   A thread of priority p has p + 1 shares.  Threads are also
+//	   grouped into tenants by uid: each tenant with threads to run
+//	   gets the same share of the CPU, split among its runnable
+//	   threads by their shares.  So a tenant can't get more of the
+//	   CPU by running more threads.
+//
+//	   The running thread is preempted once it has run for its time
+//	   slice (CFSLatency, divided among the runnable threads, but
+//	   no less than CFSMinSlice), if another thread has had less
+//	   virtual runtime by then.
+//
+//	   A thread that has been blocked gets no credit for the time it
+//	   wasn't running beyond CFSLatency / 2, so it can't hold on to
+//	   the CPU for long when it wakes.
+//
+//	The ready threads are kept in a heap, by virtual runtime.
+//
+//	Selected with "-sched cfs".
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef CFS_H
+#define CFS_H
+
+#include "copyright.h"
+#include "scheduler.h"
+#include "heap.h"
+#include "hash.h"
+#include "stats.h"
+
+const int CFSLatency = 6 * TimerTicks;	// time in which every runnable
+					// thread should get to run
+const int CFSMinSlice = TimerTicks;	// the shortest time slice
+
+// The following class counts the shares of the ready threads of one
+// tenant.
+//
+// This class is private to this module. Made public for notational
+// convenience.
+
+class CFSTenant
+{
+public:
+  int uid;      // the tenant
+  int readyShares; // shares of its threads that are ready to run
+};
+
+// The following class defines a completely fair scheduler.
+
+class CFSScheduler : public Scheduler
+{
+public:
+  CFSScheduler();
+  ~CFSScheduler();
+
+  void ReadyToRun(Thread *thread); // put it in the heap
+  Thread *FindNextToRun();         // take out the one that has had
+                                   // the least virtual runtime
+  void Print();                    // print the ready threads, with
+                                   // their virtual runtimes
+
+  bool TimerTick(); // has the running thread had its slice?
+  void SelfTest();  // test the split between tenants
+
+protected:
+  void Charge(Thread *thread, int ticks);
+  // add to its virtual runtime
+
+private:
+  int Slice();                     // the time slice, for the number
+                                   // of runnable threads
+  CFSTenant *Tenant(int uid);      // the tenant for a uid
+
+  Heap<Thread *> *ready;           // the ready threads
+  HashTable<int, CFSTenant *> *tenants; // every tenant so far, by uid
+  double minVruntime;              // no thread's virtual runtime is
+                                   // any less (except for sleepers'
+                                   // credit); never goes down
+};
+
+#endif // CFS_H
@@ -0,0 +1,551 @@
+// edf.cc
+//	Routines for the earliest-deadline-first scheduler (see edf.h).
+//
+// 	These routines assume that interrupts are already disabled, as
+//	for the Scheduler, except for SetRealTime and WaitForNextPeriod,
+//	which are called by threads.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "debug.h"
+#include "edf.h"
+#include "main.h"
+#include "synch.h"
+
+//----------------------------------------------------------------------
+// DueCompare
+//	Compare two real-time threads by when their jobs are due.
+//----------------------------------------------------------------------
+
+static int
+DueCompare(Thread *x, Thread *y)
+{
+    if (x->rtTask->due < y->rtTask->due)
+    {
+        return -1;
+    }
+    else if (x->rtTask->due > y->rtTask->due)
+    {
+        return 1;
+    }
+    else
+    {
+        return 0;
+    }
+}
+
+//----------------------------------------------------------------------
+// EDFScheduler::EDFScheduler
+// 	Initialize the scheduler, with no real-time threads.
+//----------------------------------------------------------------------
+
+EDFScheduler::EDFScheduler()
+{
+    ready = new Heap<Thread *>(DueCompare);
+    throttled = new List<Thread *>;
+    tasks = new List<EDFTask *>;
+    density = 0;
+}
+
+//----------------------------------------------------------------------
+// EDFScheduler::~EDFScheduler
+// 	De-allocate the ready lists, and the real-time parameters.
+//----------------------------------------------------------------------
+
+EDFScheduler::~EDFScheduler()
+{
+    while (!tasks->IsEmpty())
+    {
+        delete tasks->RemoveFront();
+    }
+    delete tasks;
+    delete throttled;
+    delete ready;
+}
+
+//----------------------------------------------------------------------
+// EDFScheduler::SetRealTime
+// 	Make a thread real-time, releasing its first job now -- unless
+//	the parameters make no sense, or adding it would make the total
+//	density of the real-time threads more than 1.
+//
+//	The thread must not already be real-time, and must not be on
+//	the ready list: set it up before it is forked, or from the
+//	thread itself.
+//
+//	"thread" is the thread
+//	"period" is the ticks between its releases
+//	"budget" is the ticks each job may run, no more than "deadline"
+//	"deadline" is the ticks after a release that the job is due, no
+//		more than "period"
+//
+// Returns:
+//	FALSE, if the thread can't be admitted
+//----------------------------------------------------------------------
+
+bool EDFScheduler::SetRealTime(Thread *thread, int period, int budget,
+                               int deadline)
+{
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+    double needed = (double)budget / deadline;
+    EDFTask *task;
+
+    ASSERT(thread->rtTask == NULL && thread->getStatus() != READY);
+
+    if (budget <= 0 || budget > deadline || deadline > period || density + needed > 1.0)
+    {
+        DEBUG(dbgThread, "Not admitting thread " << thread->getName() << ", density " << density << " + " << needed);
+        (void)kernel->interrupt->SetLevel(oldLevel);
+        return FALSE;
+    }
+    DEBUG(dbgThread, "Admitting thread " << thread->getName() << ": period " << period << ", budget " << budget << ", deadline " << deadline);
+
+    task = new EDFTask;
+    task->thread = thread;
+    task->period = period;
+    task->budget = budget;
+    task->deadline = deadline;
+    task->sleeping = FALSE;
+    Release(task, kernel->stats->totalTicks);
+    tasks->Append(task);
+    thread->rtTask = task;
+    density += needed;
+
+    (void)kernel->interrupt->SetLevel(oldLevel);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// EDFScheduler::Release
+// 	Start a new job for a real-time thread, with a fresh budget.
+//
+//	"task" is the real-time thread
+//	"when" is the time it is released
+//----------------------------------------------------------------------
+
+void EDFScheduler::Release(EDFTask *task, int when)
+{
+    task->release = when;
+    task->due = when + task->deadline;
+    task->used = 0;
+    task->throttled = FALSE;
+    task->missed = FALSE;
+    kernel->stats->numJobs++;
+}
+
+//----------------------------------------------------------------------
+// EDFScheduler::CheckDeadline
+// 	Count the current job of a real-time thread as missing its
+//	deadline, if it isn't done and is past due -- or is due, and its
+//	next release has come, so it can't be done in time.  Each job is
+//	counted only once.
+//
+//	"task" is the real-time thread
+//----------------------------------------------------------------------
+
+void EDFScheduler::CheckDeadline(EDFTask *task)
+{
+    int now = kernel->stats->totalTicks;
+
+    if (!task->sleeping && !task->missed &&
+        (now > task->due || now >= task->release + task->period))
+    {
+        DEBUG(dbgThread, "Thread " << task->thread->getName() << " missed its deadline of " << task->due);
+        task->missed = TRUE;
+        kernel->stats->numDeadlinesMissed++;
+    }
+}
+
+//----------------------------------------------------------------------
+// EDFScheduler::WaitForNextPeriod
+// 	Called by a real-time thread when its job is done: sleep until
+//	its next release.  If that has already passed, the latest job
+//	that is due to have been released is released at once (skipping
+//	any releases that were missed altogether, as TimerTick does).
+//	Does nothing for other threads.
+//----------------------------------------------------------------------
+
+void EDFScheduler::WaitForNextPeriod()
+{
+    Thread *thread = kernel->currentThread;
+    EDFTask *task = thread->rtTask;
+    IntStatus oldLevel;
+    int now, next;
+
+    if (task == NULL)
+    {
+        return;
+    }
+    oldLevel = kernel->interrupt->SetLevel(IntOff);
+    Account(); // the job's last ticks count against its budget
+    CheckDeadline(task);
+    now = kernel->stats->totalTicks;
+    next = task->release + task->period;
+    if (next > now)
+    {
+        task->sleeping = TRUE;
+        thread->Sleep(FALSE); // until TimerTick releases it
+    }
+    else
+    {
+        while (next + task->period <= now)
+        {
+            next += task->period;
+        }
+        Release(task, next);
+    }
+    (void)kernel->interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// EDFScheduler::ReadyToRun
+// 	Mark a thread as ready, and put it on the ready list: by when its
+//	job is due, if it is a real-time thread with budget left; at the
+//	end of the list of throttled threads, if it has none left; or
+//	with the background threads, by priority.
+//
+//	"thread" is the thread to be put on the ready list.
+//----------------------------------------------------------------------
+
+void EDFScheduler::ReadyToRun(Thread *thread)
+{
+    EDFTask *task = thread->rtTask;
+
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    DEBUG(dbgThread, "Putting thread on ready list: " << thread->getName());
+
+    thread->setStatus(READY);
+    if (task == NULL)
+    {
+        Append(thread, thread->getPriority());
+    }
+    else if (task->throttled)
+    {
+        throttled->Append(thread);
+    }
+    else
+    {
+        ready->Insert(thread);
+    }
+}
+
+//----------------------------------------------------------------------
+// EDFScheduler::FindNextToRun
+// 	Return the next thread to be scheduled onto the CPU: the
+//	real-time thread whose job is due first; or else the background
+//	thread of highest priority; or else a throttled thread.  If there
+//	are no ready threads, return NULL.
+// Side effect:
+//	Thread is removed from the ready list.
+//----------------------------------------------------------------------
+
+Thread *
+EDFScheduler::FindNextToRun()
+{
+    Thread *thread;
+
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+
+    if (!ready->IsEmpty())
+    {
+        return ready->RemoveFront();
+    }
+    thread = RemoveHighest();
+    if (thread == NULL && !throttled->IsEmpty())
+    {
+        thread = throttled->RemoveFront();
+    }
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// EDFScheduler::Charge
+// 	Count the time a real-time thread has run against the budget of
+//	its job, and throttle it once the budget is used up.
+//
+//	"thread" is the thread that ran
+//	"ticks" is how long it ran
+//----------------------------------------------------------------------
+
+void EDFScheduler::Charge(Thread *thread, int ticks)
+{
+    EDFTask *task = thread->rtTask;
+
+    if (task == NULL || task->sleeping)
+    {
+        return;
+    }
+    task->used += ticks;
+    if (!task->throttled && task->used >= task->budget)
+    {
+        DEBUG(dbgThread, "Throttling thread " << thread->getName() << " until " << task->release + task->period);
+        task->throttled = TRUE;
+    }
+}
+
+//----------------------------------------------------------------------
+// EDFScheduler::Finishing
+// 	A thread is finishing; if it is a real-time thread, forget its
+//	parameters, leaving its density for other threads.
+//
+//	"thread" is the thread
+//----------------------------------------------------------------------
+
+void EDFScheduler::Finishing(Thread *thread)
+{
+    EDFTask *task = thread->rtTask;
+
+    if (task == NULL)
+    {
+        return;
+    }
+    tasks->Remove(task);
+    density -= (double)task->budget / task->deadline;
+    thread->rtTask = NULL;
+    delete task;
+}
+
+//----------------------------------------------------------------------
+// EDFScheduler::NextRelease
+// 	Return when the next job of a sleeping or throttled thread is
+//	released, or INT_MAX if there are no such threads.  The machine
+//	must keep on taking timer interrupts until then, even if it is
+//	idle.
+//----------------------------------------------------------------------
+
+int EDFScheduler::NextRelease()
+{
+    ListIterator<EDFTask *> iter(tasks);
+    int next = INT_MAX;
+    EDFTask *task;
+
+    for (; !iter.IsDone(); iter.Next())
+    {
+        task = iter.Item();
+        if ((task->sleeping || task->throttled) && task->release + task->period < next)
+        {
+            next = task->release + task->period;
+        }
+    }
+    return next;
+}
+
+//----------------------------------------------------------------------
+// EDFScheduler::TimerTick
+// 	Called on each timer interrupt.  Charge the running thread for
+//	the time it has run; release the jobs of any sleeping or
+//	throttled threads whose periods have come round (skipping any
+//	releases that were missed altogether); and count any jobs that
+//	have missed their deadlines.
+//
+//	Then decide whether the running thread should be preempted: a
+//	real-time thread with budget left, only by a job that is due
+//	sooner; any other thread, by any ready real-time thread, and
+//	(for time slicing) by another thread of its own kind.
+//----------------------------------------------------------------------
+
+bool EDFScheduler::TimerTick()
+{
+    int now = kernel->stats->totalTicks;
+    ListIterator<EDFTask *> iter(tasks);
+    EDFTask *task;
+    Thread *thread;
+    int next;
+    bool parked;
+
+    Account();
+    for (; !iter.IsDone(); iter.Next())
+    {
+        task = iter.Item();
+        thread = task->thread;
+        next = task->release + task->period;
+        CheckDeadline(task);
+        if ((task->sleeping || task->throttled) && now >= next)
+        {
+            while (next + task->period <= now)
+            {
+                next += task->period;
+            }
+            parked = task->throttled && thread->getStatus() == READY;
+            if (parked)
+            {
+                throttled->Remove(thread);
+            }
+            Release(task, next);
+            if (task->sleeping || parked)
+            {
+                task->sleeping = FALSE;
+                ReadyToRun(thread);
+            }
+        }
+    }
+
+    task = kernel->currentThread->rtTask;
+    if (task != NULL && !task->throttled)
+    {
+        return !ready->IsEmpty() && ready->Front()->rtTask->due < task->due;
+    }
+    if (!ready->IsEmpty() || HighestReady() >= 0)
+    {
+        return TRUE;
+    }
+    return task != NULL && !throttled->IsEmpty();
+}
+
+//----------------------------------------------------------------------
+// EDFScheduler::Print
+// 	Print the ready real-time threads, by when their jobs are due,
+//	then the background threads, then the throttled threads.  For
+//	debugging.
+//----------------------------------------------------------------------
+
+void EDFScheduler::Print()
+{
+    cout << "Real-time threads, by deadline:\n";
+    ready->Apply(ThreadPrint);
+    Scheduler::Print();
+    cout << "Throttled threads:\n";
+    throttled->Apply(ThreadPrint);
+}
+
+//----------------------------------------------------------------------
+// EDF self test threads
+// 	EDFGood does a few short jobs, well within its budget, and then
+//	stops the others; EDFHog never finishes a job, so it is throttled
+//	every time, and misses every deadline; EDFBackground is an
+//	ordinary thread, which should still get the CPU.  EDFLate is
+//	held up for several periods before its first job is done.
+//----------------------------------------------------------------------
+
+static EDFScheduler *edfTest;	// the scheduler being tested
+static Semaphore *edfDone;	// V'd by each thread when it is done
+static bool edfStop;		// set once EDFGood is done
+static int edfHogTicks;		// ticks EDFHog has run
+static int edfHogJobs;		// jobs of EDFHog that it has run in
+static int edfBackgroundTicks;	// ticks EDFBackground has run
+
+static void
+EDFGood(int jobs)
+{
+    for (; jobs > 0; jobs--)
+    {
+        Scheduler::Spin(TimerTicks / 2);
+        ASSERT(!kernel->currentThread->rtTask->missed);
+        edfTest->WaitForNextPeriod();
+    }
+    edfStop = TRUE;
+    edfDone->V();
+}
+
+static void
+EDFHog()
+{
+    int release = -1;
+
+    while (!edfStop)
+    {
+        if (kernel->currentThread->rtTask->release != release)
+        {
+            release = kernel->currentThread->rtTask->release;
+            edfHogJobs++;
+        }
+        Scheduler::Spin(SystemTick);
+        edfHogTicks += SystemTick;
+    }
+    edfDone->V();
+}
+
+static void
+EDFBackground()
+{
+    while (!edfStop)
+    {
+        Scheduler::Spin(SystemTick);
+        edfBackgroundTicks += SystemTick;
+    }
+    edfDone->V();
+}
+
+static void
+EDFLate(Semaphore *go)
+{
+    EDFTask *task = kernel->currentThread->rtTask;
+    int first = task->release;
+
+    go->P();
+    edfTest->WaitForNextPeriod();
+    ASSERT(!task->sleeping && !task->missed);
+    ASSERT(task->release - first >= 3 * task->period);
+    ASSERT((task->release - first) % task->period == 0);
+    ASSERT(task->release <= kernel->stats->totalTicks);
+    edfDone->V();
+}
+
+//----------------------------------------------------------------------
+// EDFScheduler::SelfTest
+// 	Check that threads are only admitted with sensible parameters,
+//	and up to a total density of 1; that a thread that runs over its
+//	budget is throttled, leaving the CPU to the background threads,
+//	and has its missed deadlines counted; and that a thread that is
+//	late for several periods skips the releases it has missed.
+//----------------------------------------------------------------------
+
+void EDFScheduler::SelfTest()
+{
+    const int period = 5 * TimerTicks, budget = TimerTicks;
+    const int hogPeriod = 10 * TimerTicks, hogBudget = 2 * TimerTicks;
+    Thread *a = new Thread("edf a");
+    Thread *b = new Thread("edf b");
+    Thread *good, *hog, *late;
+    Semaphore *go;
+    int missed;
+
+    ASSERT(!SetRealTime(a, period, 2 * budget, budget)); // budget > deadline
+    ASSERT(!SetRealTime(a, period, budget, 2 * period)); // deadline > period
+    ASSERT(SetRealTime(a, period, 3 * budget, period)); // density .6
+    ASSERT(!SetRealTime(b, period, 3 * budget, period)); // 1.2
+    ASSERT(SetRealTime(b, period, 2 * budget, period)); // 1
+    Finishing(a);
+    Finishing(b);
+    ASSERT(density < 1e-9);
+    delete a;
+    delete b;
+
+    edfTest = this;
+    edfDone = new Semaphore("edf done", 0);
+    edfStop = FALSE;
+    edfHogTicks = edfHogJobs = edfBackgroundTicks = 0;
+    missed = kernel->stats->numDeadlinesMissed;
+    good = new Thread("edf good");
+    ASSERT(SetRealTime(good, period, budget, period));
+    hog = new Thread("edf hog");
+    ASSERT(SetRealTime(hog, hogPeriod, hogBudget, hogPeriod));
+    good->Fork((VoidFunctionPtr)EDFGood, (void *)10);
+    hog->Fork((VoidFunctionPtr)EDFHog, NULL);
+    (new Thread("edf background"))->Fork((VoidFunctionPtr)EDFBackground, NULL);
+    for (int i = 0; i < 3; i++)
+    {
+        edfDone->P();
+    }
+    missed = kernel->stats->numDeadlinesMissed - missed;
+
+    DEBUG(dbgThread, "EDF self test: hog ran " << edfHogTicks << " ticks in " << edfHogJobs << " jobs, missing " << missed << "; background ran " << edfBackgroundTicks);
+    ASSERT(edfHogJobs > 1);
+    ASSERT(edfHogTicks <= edfHogJobs * (hogBudget + TimerTicks + SystemTick));
+    ASSERT(edfBackgroundTicks > 0);
+    ASSERT(missed == edfHogJobs || missed == edfHogJobs - 1);
+
+    go = new Semaphore("edf go", 0);
+    late = new Thread("edf late");
+    ASSERT(SetRealTime(late, 2 * budget, budget, 2 * budget));
+    late->Fork((VoidFunctionPtr)EDFLate, (void *)go);
+    Spin(7 * budget);
+    go->V();
+    edfDone->P();
+
+    delete go;
+    delete edfDone;
+}
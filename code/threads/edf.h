@@ -0,0 +1,109 @@
+// edf.h
+//	Data structures for an earliest-deadline-first real-time
+//	scheduler.
+//
+//	A thread becomes a real-time thread by asking the scheduler for
+//	a period, a budget and a deadline (SetRealTime).  From then on,
+//	it is released once every period: each release starts a new job,
+//	which may run for up to the budget, and should be done within
+//	the deadline of the release.  A job is done when the thread calls
+//	WaitForNextPeriod; the thread then sleeps until its next release.
+//
+//	   The ready real-time threads run before any other thread, the
+//	   one whose job is due first running first; they are not time
+//	   sliced among themselves.  The other threads run in the
+//	   background, by priority, as with the default Scheduler.
+//
+//	   Releases are made by the timer interrupt handler, so a job
+//	   is released up to a timer interrupt late.
+//
+//	   A job that uses up its budget is throttled: until its next
+//	   release, it runs only if no other thread is ready.  So a
+//	   thread that runs over can't make the others miss their
+//	   deadlines.
+//
+//	   A thread is only made real-time if the densities of all the
+//	   real-time threads (budget / deadline) add up to no more than
+//	   1, so that EDF can meet all the deadlines.
+//
+//	Jobs that are not done by their deadlines are counted in the
+//	Statistics.
+//
+//	Selected with "-sched edf".
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef EDF_H
+#define EDF_H
+
+#include "copyright.h"
+#include "scheduler.h"
+#include "heap.h"
+
+// The following class holds the real-time parameters and the state of
+// the current job of a real-time thread.
+//
+// This class is private to this module. Made public for notational
+// convenience.
+
+class EDFTask
+{
+public:
+  Thread *thread; // the real-time thread
+  int period;     // ticks between its releases
+  int budget;     // ticks each job may run
+  int deadline;   // ticks after its release each job is due
+
+  int release;    // when the current job was released
+  int due;        // when it is due
+  int used;       // ticks it has run
+  bool throttled; // has it used up its budget?
+  bool sleeping;  // is it done, waiting for the next release?
+  bool missed;    // has it been counted as missing its deadline?
+};
+
+// The following class defines an earliest-deadline-first scheduler.
+
+class EDFScheduler : public Scheduler
+{
+public:
+  EDFScheduler();
+  ~EDFScheduler();
+
+  void ReadyToRun(Thread *thread); // put it on the right ready list
+  Thread *FindNextToRun();         // the real-time thread due first,
+                                   // or else a background thread
+  void Print();                    // print the ready lists
+
+  bool TimerTick(); // make releases; should the running
+                    // thread be preempted?
+
+  bool SetRealTime(Thread *thread, int period, int budget, int deadline);
+  // make a thread real-time, if it can
+  // be admitted
+  void WaitForNextPeriod(); // the current job is done
+  int NextRelease();        // when a sleeping or throttled
+                            // thread is next released
+  void SelfTest();          // test admission, throttling and
+                            // deadline misses
+
+protected:
+  void Charge(Thread *thread, int ticks);
+  // count it against the budget
+  void Finishing(Thread *thread); // forget a real-time thread
+
+private:
+  void Release(EDFTask *task, int when); // start a new job
+  void CheckDeadline(EDFTask *task);     // count it, if it has
+                                         // missed its deadline
+
+  Heap<Thread *> *ready;        // ready real-time threads, by due time
+  List<Thread *> *throttled;    // ready threads that have used up
+                                // their budgets
+  List<EDFTask *> *tasks;       // every real-time thread
+  double density;               // total density of the tasks
+};
+
+#endif // EDF_H
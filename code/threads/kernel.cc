@@ -17,6 +17,14 @@
 #include "synchconsole.h"
 #include "synchdisk.h"
 #include "post.h"
+#include "profile.h"
+#include "memtrace.h"
+#include "cache.h"
+#include "timing.h"
+#include "native.h"
+#include "mlfq.h"
+#include "cfs.h"
+#include "edf.h"
 
 //----------------------------------------------------------------------
 // Kernel::Kernel
@@ -26,10 +34,32 @@
 
 Kernel::Kernel(int argc, char **argv)
 {
+    int pageSize = PageSize; // the default machine geometry
+    int numPhysPages = NumPhysPages;
+    int tlbSize = TLBSize;
+    int tlbWays = 0; // fully associative
+
     randomSlice = FALSE;
     debugUserProg = FALSE;
+    blockSim = FALSE;
+    nativeFile = NULL;
+    tlbPolicy = TLBFifo;
     consoleIn = NULL;  // default is stdin
     consoleOut = NULL; // default is stdout
+    profileFile = NULL; // default is not to profile
+    symbolFile = NULL;
+    memTraceFile = NULL; // default is not to trace memory
+    memTraceSample = 1;
+    iCacheSize = dCacheSize = 0; // default is not to simulate caches
+    cacheWays = 2;
+    cacheLineSize = 16;
+    missPenalty = 10;
+    timingModel = NULL; // default is UserTick for every instruction
+    snapshotFile = NULL; // default is not to save a snapshot
+    poolStats = FALSE;
+    tickless = FALSE; // default is to poll for input even when idle
+    usecPerTick = 0;
+    schedPolicy = SchedPriority; // default is the plain priority scheduler
 #ifndef FILESYS_STUB
     formatFlag = FALSE;
 #endif
@@ -50,6 +80,134 @@ Kernel::Kernel(int argc, char **argv)
         {
             debugUserProg = TRUE;
         }
+        else if (strcmp(argv[i], "-bb") == 0)
+        {
+            blockSim = TRUE;
+        }
+        else if (strcmp(argv[i], "-native") == 0)
+        {
+            ASSERT(i + 1 < argc);
+            nativeFile = argv[i + 1];
+            blockSim = TRUE; // compiled blocks are run by the block engine
+            i++;
+        }
+        else if (strcmp(argv[i], "-prof") == 0)
+        {
+            ASSERT(i + 1 < argc);
+            profileFile = argv[i + 1];
+            i++;
+        }
+        else if (strcmp(argv[i], "-profsym") == 0)
+        {
+            ASSERT(i + 1 < argc);
+            symbolFile = argv[i + 1];
+            i++;
+        }
+        else if (strcmp(argv[i], "-mtrace") == 0)
+        {
+            ASSERT(i + 1 < argc);
+            memTraceFile = argv[i + 1];
+            i++;
+        }
+        else if (strcmp(argv[i], "-mtracesample") == 0)
+        {
+            ASSERT(i + 1 < argc); // next argument is int
+            memTraceSample = atoi(argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "-icache") == 0)
+        {
+            ASSERT(i + 1 < argc); // next argument is int
+            iCacheSize = atoi(argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "-dcache") == 0)
+        {
+            ASSERT(i + 1 < argc); // next argument is int
+            dCacheSize = atoi(argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "-cacheways") == 0)
+        {
+            ASSERT(i + 1 < argc); // next argument is int
+            cacheWays = atoi(argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "-cacheline") == 0)
+        {
+            ASSERT(i + 1 < argc); // next argument is int
+            cacheLineSize = atoi(argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "-misspenalty") == 0)
+        {
+            ASSERT(i + 1 < argc); // next argument is int
+            missPenalty = atoi(argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "-timing") == 0)
+        {
+            ASSERT(i + 1 < argc);
+            timingModel = argv[i + 1];
+            i++;
+        }
+        else if (strcmp(argv[i], "-tickless") == 0)
+        {
+            tickless = TRUE;
+        }
+        else if (strcmp(argv[i], "-pace") == 0)
+        {
+            ASSERT(i + 1 < argc); // next argument is int
+            usecPerTick = atoi(argv[i + 1]);
+            tickless = TRUE; // pacing is done while idle
+            i++;
+        }
+        else if (strcmp(argv[i], "-sched") == 0)
+        {
+            ASSERT(i + 1 < argc);
+            schedPolicy = Scheduler::PolicyNamed(argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "-pools") == 0)
+        {
+            poolStats = TRUE;
+        }
+        else if (strcmp(argv[i], "-save") == 0)
+        {
+            ASSERT(i + 1 < argc);
+            snapshotFile = argv[i + 1];
+            i++;
+        }
+        else if (strcmp(argv[i], "-ps") == 0)
+        {
+            ASSERT(i + 1 < argc); // next argument is int
+            pageSize = atoi(argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "-pp") == 0)
+        {
+            ASSERT(i + 1 < argc); // next argument is int
+            numPhysPages = atoi(argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "-tlb") == 0)
+        {
+            ASSERT(i + 1 < argc); // next argument is int
+            tlbSize = atoi(argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "-tlbways") == 0)
+        {
+            ASSERT(i + 1 < argc); // next argument is int
+            tlbWays = atoi(argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "-tlbpolicy") == 0)
+        {
+            ASSERT(i + 1 < argc);
+            tlbPolicy = TLB::PolicyNamed(argv[i + 1]);
+            i++;
+        }
         else if (strcmp(argv[i], "-ci") == 0)
         {
             ASSERT(i + 1 < argc);
@@ -83,7 +241,17 @@ Kernel::Kernel(int argc, char **argv)
         else if (strcmp(argv[i], "-u") == 0)
         {
             cout << "Partial usage: nachos [-rs randomSeed]\n";
-            cout << "Partial usage: nachos [-s]\n";
+            cout << "Partial usage: nachos [-s] [-bb] [-prof profileFile] [-profsym symbolFile]\n";
+            cout << "Partial usage: nachos [-native compiledBlocks]\n";
+            cout << "Partial usage: nachos [-mtrace traceFile] [-mtracesample #]\n";
+            cout << "Partial usage: nachos [-icache #] [-dcache #] [-cacheways #] [-cacheline #] [-misspenalty #]\n";
+            cout << "Partial usage: nachos [-timing mips|costFile]\n";
+            cout << "Partial usage: nachos [-ps #] [-pp #] [-tlb #] [-tlbways #]\n";
+            cout << "Partial usage: nachos [-tlbpolicy fifo|lru|nru|clock|random]\n";
+            cout << "Partial usage: nachos [-tickless] [-pace usecPerTick]\n";
+            cout << "Partial usage: nachos [-sched priority|mlfq|cfs|edf]\n";
+            cout << "Partial usage: nachos [-pools]\n";
+            cout << "Partial usage: nachos [-save snapshotFile]\n";
             cout << "Partial usage: nachos [-ci consoleIn] [-co consoleOut]\n";
 #ifndef FILESYS_STUB
             cout << "Partial usage: nachos [-nf]\n";
@@ -91,6 +259,7 @@ Kernel::Kernel(int argc, char **argv)
             cout << "Partial usage: nachos [-n #] [-m #]\n";
         }
     }
+    SetMachineGeometry(pageSize, numPhysPages, tlbSize, tlbWays);
 }
 
 //----------------------------------------------------------------------
@@ -105,14 +274,45 @@ void Kernel::Initialize()
     // We didn't explicitly allocate the current thread we are running in.
     // But if it ever tries to give up the CPU, we better have a Thread
     // object to save its state.
+    threads = new ThreadTable();    // give out thread ids
     currentThread = new Thread("main");
     currentThread->setStatus(RUNNING);
 
     stats = new Statistics();       // collect statistics
+    if (profileFile != NULL)
+        profile = new Profile(profileFile, symbolFile); // profile user programs
+    else
+        profile = NULL;
+    if (memTraceFile != NULL) // trace user memory accesses
+        memTrace = new MemTrace(memTraceFile, memTraceSample);
+    else
+        memTrace = NULL;
     interrupt = new Interrupt;      // start up interrupt handling
-    scheduler = new Scheduler();    // initialize the ready queue
+    if (tickless)
+        interrupt->SetTickless(usecPerTick);
+    if (schedPolicy == SchedMLFQ)   // initialize the ready queue
+        scheduler = new MLFQScheduler();
+    else if (schedPolicy == SchedCFS)
+        scheduler = new CFSScheduler();
+    else if (schedPolicy == SchedEDF)
+        scheduler = new EDFScheduler();
+    else
+        scheduler = new Scheduler();
     alarm = new Alarm(randomSlice); // start up time slicing
-    machine = new Machine(debugUserProg);
+    machine = new Machine(debugUserProg, blockSim);
+    if (machine->tlb != NULL)
+        machine->tlb->SetPolicy(tlbPolicy);
+    if (iCacheSize > 0) // simulate caches
+        machine->iCache = new Cache(iCacheSize, cacheWays, cacheLineSize,
+                                    missPenalty);
+    if (dCacheSize > 0)
+        machine->dCache = new Cache(dCacheSize, cacheWays, cacheLineSize,
+                                    missPenalty);
+    if (nativeFile != NULL) // run blocks compiled ahead of time
+        machine->nativeCode = new NativeCode(nativeFile);
+    if (timingModel != NULL) // charge instructions by opcode
+        machine->timing = new TimingModel(
+            strcmp(timingModel, "mips") == 0 ? NULL : timingModel);
     synchConsoleIn = new SynchConsoleInput(consoleIn);    // input from stdin
     synchConsoleOut = new SynchConsoleOutput(consoleOut); // output to stdout
     synchDisk = new SynchDisk();                          //
@@ -136,6 +336,8 @@ void Kernel::Initialize()
 Kernel::~Kernel()
 {
     delete stats;
+    delete profile;
+    delete memTrace;
     delete interrupt;
     delete scheduler;
     delete alarm;
@@ -161,6 +363,7 @@ void Kernel::ThreadSelfTest()
     SynchList<int> *synchList;
 
     LibSelfTest(); // test library routines
+    ThreadTable::SelfTest(); // test thread ids
 
     currentThread->SelfTest(); // test thread switching
 
@@ -174,6 +377,8 @@ void Kernel::ThreadSelfTest()
     synchList = new SynchList<int>;
     synchList->SelfTest(9);
     delete synchList;
+
+    scheduler->SelfTest(); // test the scheduling class, if -sched
 }
 
 //----------------------------------------------------------------------
@@ -259,3 +464,98 @@ void Kernel::NetworkTest()
 
     // Then we're done!
 }
+
+// A snapshot file starts with this, followed by the size of the
+// machine it was taken on
+static const int SnapshotMagic = 0x534e4150;
+
+//----------------------------------------------------------------------
+// Kernel::SaveSnapshot
+// 	If we were asked to (with -save), save the state of the machine
+//	to a snapshot file, just as it is about to start running the
+//	user program in "space".  Only the first program is saved.
+//
+//	The snapshot holds the statistics, when each kind of interrupt is
+//	next due, the CPU registers and TLB, the page table, and the pages
+//	of physical memory it maps.  Kernel threads and the devices can't
+//	be saved: RestoreSnapshot starts from a freshly booted kernel.
+//----------------------------------------------------------------------
+
+void Kernel::SaveSnapshot(AddrSpace *space)
+{
+    int header[6];
+    int fd;
+
+    if (snapshotFile == NULL)
+        return;
+    DEBUG(dbgAddr, "Saving snapshot " << snapshotFile);
+
+    fd = OpenForWrite(snapshotFile);
+    header[0] = SnapshotMagic;
+    header[1] = PageSize;
+    header[2] = NumPhysPages;
+    header[3] = TLBSize;
+    header[4] = (machine->tlb != NULL);
+    header[5] = TLBWays;
+    WriteFile(fd, (char *)header, sizeof(header));
+    WriteFile(fd, (char *)stats, sizeof(Statistics));
+    interrupt->WriteSnapshot(fd);
+    machine->WriteSnapshot(fd);
+    space->WriteSnapshot(fd);
+    Close(fd);
+
+    snapshotFile = NULL;
+}
+
+//----------------------------------------------------------------------
+// Kernel::RestoreSnapshot
+// 	Restore the state saved by SaveSnapshot, into a new address
+//	space, which can then be resumed.  This skips loading the
+//	program, and any time the kernel spent before saving it.
+//
+//	Returns NULL if the snapshot can't be read, or was taken on a
+//	machine of a different size.
+//
+//	"fileName" -- the snapshot file
+//----------------------------------------------------------------------
+
+AddrSpace *
+Kernel::RestoreSnapshot(char *fileName)
+{
+    int header[6];
+    AddrSpace *space;
+    int fd = OpenForReadWrite(fileName, FALSE);
+
+    if (fd < 0)
+    {
+        cerr << "Unable to open snapshot " << fileName << "\n";
+        return NULL;
+    }
+    if (ReadPartial(fd, (char *)header, sizeof(header)) != sizeof(header) ||
+        header[0] != SnapshotMagic)
+    {
+        cerr << fileName << " is not a snapshot\n";
+        Close(fd);
+        return NULL;
+    }
+    if (header[1] != PageSize || header[2] != NumPhysPages ||
+        header[3] != TLBSize || header[4] != (machine->tlb != NULL) ||
+        header[5] != TLBWays)
+    {
+        cerr << "Snapshot " << fileName << " is of a machine with "
+             << header[2] << " pages of " << header[1] << " bytes, and "
+             << (header[4] ? header[3] : 0) << " TLB entries, "
+             << header[5] << " to a set\n";
+        Close(fd);
+        return NULL;
+    }
+    DEBUG(dbgAddr, "Restoring snapshot " << fileName);
+
+    space = new AddrSpace;
+    Read(fd, (char *)stats, sizeof(Statistics));
+    interrupt->ReadSnapshot(fd);
+    machine->ReadSnapshot(fd);
+    space->ReadSnapshot(fd);
+    Close(fd);
+    return space;
+}
@@ -12,6 +12,7 @@
 #include "debug.h"
 #include "utility.h"
 #include "thread.h"
+#include "threadtable.h"
 #include "scheduler.h"
 #include "interrupt.h"
 #include "stats.h"
@@ -24,6 +25,8 @@ class PostOfficeOutput;
 class SynchConsoleInput;
 class SynchConsoleOutput;
 class SynchDisk;
+class Profile;
+class MemTrace;
 
 class Kernel {
   public:
@@ -40,14 +43,25 @@ class Kernel {
     void ConsoleTest();         // interactive console self test
 
     void NetworkTest();         // interactive 2-machine network test
+
+    void SaveSnapshot(AddrSpace *space);
+                                // save the state of the machine, as it
+                                // starts to run "space", if "-save"
+    AddrSpace *RestoreSnapshot(char *fileName);
+                                // restore it, ready to resume
     
 // These are public for notational convenience; really, 
 // they're global variables used everywhere.
 
     Thread *currentThread;	// the thread holding the CPU
+    ThreadTable *threads;	// every thread, by tid
     Scheduler *scheduler;	// the ready list
     Interrupt *interrupt;	// interrupt status
     Statistics *stats;		// performance metrics
+    Profile *profile;		// user program profile, or NULL
+    MemTrace *memTrace;		// user memory access trace, or NULL
+    bool poolStats;		// print the allocation counts of the
+				// pools at halt (see pool.h)?
     Alarm *alarm;		// the software alarm clock    
     Machine *machine;           // the simulated CPU
     SynchConsoleInput *synchConsoleIn;
@@ -62,9 +76,32 @@ class Kernel {
   private:
     bool randomSlice;		// enable pseudo-random time slicing
     bool debugUserProg;         // single step user program
+    bool blockSim;              // run user programs a basic block
+                                // at a time (see blocksim.cc)
+    char *nativeFile;           // library of blocks compiled ahead of
+                                // time, if any (see native.h)
+    TLBPolicy tlbPolicy;        // how the TLB replaces entries, if
+                                // there is one
     double reliability;         // likelihood messages are dropped
     char *consoleIn;            // file to read console input from
     char *consoleOut;           // file to send console output to
+    char *profileFile;          // file to write the profile to, if any
+    char *symbolFile;           // function names for the profile
+    char *memTraceFile;         // file to trace memory accesses to, if any
+    int memTraceSample;         // trace one access in this many
+    int iCacheSize;             // bytes in the simulated caches, or 0
+    int dCacheSize;             // if there is no such cache
+    int cacheWays;              // lines in each set of a cache
+    int cacheLineSize;          // bytes in each line
+    int missPenalty;            // ticks to charge for a cache miss
+    char *timingModel;          // "mips", or a file of instruction
+                                // costs; NULL for the flat model
+    char *snapshotFile;         // where to save a snapshot, if anywhere
+    bool tickless;              // wait on the host when idle, rather
+                                // than polling for input?
+    int usecPerTick;            // if so, pace simulated time at this
+                                // many host microseconds a tick, or 0
+    SchedPolicy schedPolicy;    // which scheduler to run threads with
 #ifndef FILESYS_STUB
     bool formatFlag;          // format the disk if this is true
 #endif
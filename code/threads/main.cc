@@ -3,7 +3,18 @@
 //	operating system kernel.
 //
 // Usage: nachos -d <debugflags> -rs <random seed #>
-//              -s -x <nachos file> -ci <consoleIn> -co <consoleOut>
+//              -s -bb -prof <profile file> -profsym <symbol file>
+//              -native <compiled blocks>
+//              -mtrace <trace file> -mtracesample <interval>
+//              -mtracedump <trace file>
+//              -icache <bytes> -dcache <bytes> -cacheways <# lines per set>
+//              -cacheline <bytes> -misspenalty <ticks>
+//              -timing <mips or cost file> -tickless -pace <usec per tick>
+//              -sched <policy> -pools
+//              -x <nachos file> -ci <consoleIn> -co <consoleOut>
+//              -ps <page size> -pp <# phys pages> -tlb <# TLB entries>
+//              -tlbways <# entries per set> -tlbpolicy <policy>
+//              -save <snapshot file> -restore <snapshot file>
 //              -f -cp <unix file> <nachos file>
 //              -p <nachos file> -r <nachos file> -l -D
 //              -n <network reliability> -m <machine id>
@@ -13,7 +24,52 @@
 //    -rs causes Yield to occur at random (but repeatable) spots
 //    -z prints the copyright message
 //    -s causes user programs to be executed in single-step mode
+//    -bb runs user programs with the basic block engine, rather than
+//	one instruction at a time
+//    -native runs user programs with the basic block engine, using the
+//	blocks in the named library, compiled ahead of time by noff2c,
+//	where it can (see machine/native.h)
+//    -prof counts the user instructions run, by address, by kind and
+//	by function, and writes the counts to the named file when Nachos
+//	halts (see machine/profile.h)
+//    -profsym names the functions in the profile, from a symbol table
+//	printed by nm
+//    -mtrace writes each instruction fetch, load and store made by user
+//	programs to the named file (see machine/memtrace.h)
+//    -mtracesample only traces one access in every so many
+//    -mtracedump prints a memory trace, one access per line
+//    -icache, -dcache simulate an instruction or data cache of the given
+//	size, and charge user ticks for its misses (see machine/cache.h)
+//    -cacheways, -cacheline set the associativity (2 by default) and
+//	line size (16 bytes) of the caches
+//    -misspenalty sets the ticks charged for a cache miss (10 by default)
+//    -timing charges each user instruction by its opcode, as on a MIPS
+//	R3000, or with the costs in the named file, rather than UserTick
+//	for all of them (see machine/timing.h)
+//    -tickless makes an idle Nachos wait on the host for console or
+//	network input, instead of polling for it (see Interrupt::WaitForHost)
+//    -pace also keeps simulated time from running ahead of the host's,
+//	at the given microseconds per tick
+//    -sched picks the scheduler: priority (the default) runs the ready
+//	thread of highest priority, and mlfq a multi-level feedback queue
+//	that works out priorities from how threads use the CPU (see
+//	threads/mlfq.h), cfs shares out the CPU fairly among uids,
+//	and by priority within a uid (see threads/cfs.h), and edf runs
+//	real-time threads by their deadlines (see threads/edf.h)
+//    -pools prints, when Nachos halts, how many objects the kernel has
+//	allocated from its pools (see lib/pool.h)
+//    -ps sets the page size of the simulated machine (a power of 2)
+//    -pp sets the number of pages of physical memory
+//    -tlb sets the number of TLB entries (if there is a TLB)
+//    -tlbways sets the number of TLB entries in each set (by default,
+//	the TLB is fully associative)
+//    -tlbpolicy sets how the TLB picks an entry to replace: fifo (the
+//	default), lru, nru, clock or random
 //    -x runs a user program
+//    -save saves the state of the machine to a file, as it starts to run
+//	the user program
+//    -restore runs a user program from where a snapshot was saved,
+//	instead of loading it
 //    -ci specify file for console input (stdin is the default)
 //    -co specify file for console output (stdout is the default)
 //    -n sets the network reliability
@@ -45,6 +101,7 @@
 #include "filesys.h"
 #include "openfile.h"
 #include "sysdep.h"
+#include "memtrace.h"
 
 #ifdef TUT
 
@@ -159,6 +216,32 @@ void Print(char *name)
     return;
 }
 
+//----------------------------------------------------------------------
+// DumpMemTrace
+//      Print the memory trace in the UNIX file "name", one access per
+//      line: the kind of access, the virtual and physical addresses,
+//      the size and the thread id.
+//----------------------------------------------------------------------
+
+static void
+DumpMemTrace(char *name)
+{
+    static const char *kindNames[NumTraceKinds] = {"fetch", "load", "store"};
+    MemTraceReader trace(name);
+    MemTraceRecord record;
+
+    if (!trace.IsOpen())
+    {
+        printf("DumpMemTrace: %s is not a memory trace\n", name);
+        return;
+    }
+    printf("# page size %d, one access in %d\n", trace.getPageSize(),
+           trace.getSampleInterval());
+    while (trace.Next(&record))
+        printf("%s %d %d %d %d\n", kindNames[record.kind], record.virtAddr,
+               record.physAddr, record.size, record.thread);
+}
+
 //----------------------------------------------------------------------
 // main
 // 	Bootstrap the operating system kernel.
@@ -178,6 +261,8 @@ int main(int argc, char **argv)
     int i;
     char *debugArg = "";
     char *userProgName = NULL; // default is not to execute a user prog
+    char *snapshotName = NULL; // or to resume one from a snapshot
+    char *traceDumpName = NULL;
     bool threadTestFlag = false;
     bool consoleTestFlag = false;
     bool networkTestFlag = false;
@@ -211,6 +296,18 @@ int main(int argc, char **argv)
             userProgName = argv[i + 1];
             i++;
         }
+        else if (strcmp(argv[i], "-restore") == 0)
+        {
+            ASSERT(i + 1 < argc);
+            snapshotName = argv[i + 1];
+            i++;
+        }
+        else if (strcmp(argv[i], "-mtracedump") == 0)
+        {
+            ASSERT(i + 1 < argc);
+            traceDumpName = argv[i + 1];
+            i++;
+        }
         else if (strcmp(argv[i], "-K") == 0)
         {
             threadTestFlag = TRUE;
@@ -256,6 +353,8 @@ int main(int argc, char **argv)
         {
             cout << "Partial usage: nachos [-z -d debugFlags]\n";
             cout << "Partial usage: nachos [-x programName]\n";
+            cout << "Partial usage: nachos [-restore snapshotFile]\n";
+            cout << "Partial usage: nachos [-mtracedump traceFile]\n";
             cout << "Partial usage: nachos [-K] [-C] [-N]\n";
 #ifndef FILESYS_STUB
             cout << "Partial usage: nachos [-cp UnixFile NachosFile]\n";
@@ -294,6 +393,10 @@ int main(int argc, char **argv)
     {
         kernel->NetworkTest(); // two-machine test of the network
     }
+    if (traceDumpName != NULL)
+    {
+        DumpMemTrace(traceDumpName);
+    }
 
 #ifndef FILESYS_STUB
     if (removeFileName != NULL)
@@ -329,6 +432,15 @@ int main(int argc, char **argv)
             ASSERTNOTREACHED(); // Execute never returns
         }
     }
+    else if (snapshotName != NULL)
+    {
+        AddrSpace *space = kernel->RestoreSnapshot(snapshotName);
+        if (space != NULL)
+        {
+            space->Resume();    // pick up where the snapshot left off
+            ASSERTNOTREACHED(); // Resume never returns
+        }
+    }
 
     // If we don't run a user program, we may get here.
     // Calling "return" would terminate the program.
@@ -0,0 +1,251 @@
+// mlfq.cc
+//	Routines for the multi-level feedback queue scheduler (see mlfq.h).
+//
+// 	These routines assume that interrupts are already disabled, as
+//	for the Scheduler.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "debug.h"
+#include "mlfq.h"
+#include "main.h"
+#include "synch.h"
+
+//----------------------------------------------------------------------
+// MLFQScheduler::MLFQScheduler
+// 	Initialize the scheduler, with no ready threads and no boosts
+//	yet.
+//----------------------------------------------------------------------
+
+MLFQScheduler::MLFQScheduler()
+{
+    ASSERT(MLFQLevels <= NumPriorities);
+    numBoosts = 0;
+    lastBoost = 0;
+}
+
+//----------------------------------------------------------------------
+// MLFQScheduler::CatchUp
+// 	If there has been a priority boost since a thread's level was
+//	last looked at, it is back at the top level.  Threads that were
+//	on the ready list are moved by Boost itself; the others (running
+//	or blocked) are dealt with here, the next time they matter.
+//
+//	"thread" is the thread
+//----------------------------------------------------------------------
+
+void MLFQScheduler::CatchUp(Thread *thread)
+{
+    if (thread->schedBoost != numBoosts)
+    {
+        thread->schedLevel = 0;
+        thread->schedTicks = 0;
+        thread->schedBoost = numBoosts;
+    }
+}
+
+//----------------------------------------------------------------------
+// MLFQScheduler::ReadyToRun
+// 	Mark a thread as ready, and put it at the end of the queue for
+//	its level.
+//
+//	"thread" is the thread to be put on the ready list.
+//----------------------------------------------------------------------
+
+void MLFQScheduler::ReadyToRun(Thread *thread)
+{
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    DEBUG(dbgThread, "Putting thread on ready list: " << thread->getName());
+
+    CatchUp(thread);
+    thread->setStatus(READY);
+    Append(thread, MLFQLevels - 1 - thread->schedLevel);
+}
+
+//----------------------------------------------------------------------
+// MLFQScheduler::Charge
+// 	Add the time a thread has just run to the time it has had at its
+//	level.  Once that comes to the level's quantum, move it down a
+//	level (unless it is already at the bottom), with a fresh quantum.
+//
+//	"thread" is the thread that ran
+//	"ticks" is how long it ran
+//----------------------------------------------------------------------
+
+void MLFQScheduler::Charge(Thread *thread, int ticks)
+{
+    CatchUp(thread);
+    thread->schedTicks += ticks;
+    if (thread->schedTicks >= Quantum(thread->schedLevel))
+    {
+        if (thread->schedLevel < MLFQLevels - 1)
+        {
+            thread->schedLevel++;
+            DEBUG(dbgThread, "Moving thread " << thread->getName() << " down to level " << thread->schedLevel);
+        }
+        thread->schedTicks = 0;
+    }
+}
+
+//----------------------------------------------------------------------
+// MLFQScheduler::WaitingForIO
+// 	A thread is blocking, to wait for a device; move it up a level,
+//	with a fresh quantum, so that it runs soon once the device is
+//	done.  The time it has run so far is charged first, at its old
+//	level.
+//
+//	"thread" is the thread (the running one)
+//----------------------------------------------------------------------
+
+void MLFQScheduler::WaitingForIO(Thread *thread)
+{
+    ASSERT(thread == kernel->currentThread);
+    Account();
+    if (thread->schedLevel > 0)
+    {
+        thread->schedLevel--;
+        DEBUG(dbgThread, "Moving thread " << thread->getName() << " up to level " << thread->schedLevel);
+    }
+    thread->schedTicks = 0;
+}
+
+//----------------------------------------------------------------------
+// MLFQScheduler::Boost
+// 	Put every thread back at the top level, with a fresh quantum.
+//	The ready threads are moved to the top queue, in the order they
+//	would have run (the highest levels first).
+//----------------------------------------------------------------------
+
+void MLFQScheduler::Boost()
+{
+    Thread *thread;
+
+    DEBUG(dbgThread, "Boosting all threads to the top level");
+    numBoosts++;
+    lastBoost = kernel->stats->totalTicks;
+    for (int level = 1; level < MLFQLevels; level++)
+    {
+        List<Thread *> *queue = readyList[MLFQLevels - 1 - level];
+
+        while (!queue->IsEmpty())
+        {
+            thread = queue->RemoveFront();
+            CatchUp(thread);
+            Append(thread, MLFQLevels - 1);
+        }
+        readyMask &= ~(1U << (MLFQLevels - 1 - level));
+    }
+}
+
+//----------------------------------------------------------------------
+// MLFQScheduler::TimerTick
+// 	Called on each timer interrupt.  Boost every thread to the top
+//	level, if it is time, and then decide whether the running thread
+//	should give up the CPU: only if it has used up its quantum, or a
+//	thread at a higher level is ready.  A CPU-bound thread at a low
+//	level therefore runs through several timer interrupts in a row.
+//----------------------------------------------------------------------
+
+bool MLFQScheduler::TimerTick()
+{
+    Thread *thread = kernel->currentThread;
+    int highest;
+
+    if (kernel->stats->totalTicks - lastBoost >= MLFQBoostTicks)
+    {
+        Account(); // the time before the boost counts at the old level
+        Boost();
+    }
+    CatchUp(thread);
+    if (thread->schedTicks + RunningTicks() >= Quantum(thread->schedLevel))
+    {
+        return TRUE;
+    }
+    highest = HighestReady();
+    return highest >= 0 && MLFQLevels - 1 - highest < thread->schedLevel;
+}
+
+//----------------------------------------------------------------------
+// MLFQScheduler::Print
+// 	Print the ready threads at each level, for debugging.
+//----------------------------------------------------------------------
+
+void MLFQScheduler::Print()
+{
+    cout << "Ready list contents:\n";
+    for (int level = 0; level < MLFQLevels; level++)
+    {
+        cout << "Level " << level << ", quantum " << Quantum(level) << ":\n";
+        readyList[MLFQLevels - 1 - level]->Apply(ThreadPrint);
+    }
+}
+
+//----------------------------------------------------------------------
+// MLFQWaker
+// 	Finish the I/O the MLFQ self test is waiting for.
+//
+//	"io" is the semaphore it is waiting on
+//----------------------------------------------------------------------
+
+static void MLFQWaker(Semaphore *io)
+{
+    io->V();
+}
+
+//----------------------------------------------------------------------
+// MLFQScheduler::SelfTest
+// 	Check, on the running thread, that using up a quantum moves a
+//	thread down a level, that blocking for I/O moves it back up
+//	(but not I/O that doesn't block), and that the periodic boost
+//	puts it back at the top.
+//----------------------------------------------------------------------
+
+void MLFQScheduler::SelfTest()
+{
+    Thread *thread = kernel->currentThread;
+    Semaphore *io = new Semaphore("mlfq io", 0);
+    Thread *waker;
+    IntStatus oldLevel;
+    int boosts;
+
+    // start just after a boost, so that the next one is a while off
+    oldLevel = kernel->interrupt->SetLevel(IntOff);
+    Account();
+    Boost();
+    CatchUp(thread);
+    (void)kernel->interrupt->SetLevel(oldLevel);
+    ASSERT(thread->schedLevel == 0);
+
+    Spin(Quantum(0));
+    thread->Yield();
+    ASSERT(thread->schedLevel == 1);
+
+    io->V(); // the I/O is already done, so P doesn't block
+    thread->waitingForIO = TRUE;
+    io->P();
+    thread->waitingForIO = FALSE;
+    ASSERT(thread->schedLevel == 1);
+
+    waker = new Thread("mlfq waker");
+    oldLevel = kernel->interrupt->SetLevel(IntOff); // so P blocks
+    waker->Fork((VoidFunctionPtr)MLFQWaker, (void *)io);
+    thread->waitingForIO = TRUE;
+    io->P();
+    thread->waitingForIO = FALSE;
+    ASSERT(thread->schedLevel == 0);
+    (void)kernel->interrupt->SetLevel(oldLevel);
+
+    Spin(Quantum(0));
+    thread->Yield();
+    ASSERT(thread->schedLevel == 1);
+    for (boosts = numBoosts; numBoosts == boosts;)
+    {
+        Spin(SystemTick);
+    }
+    ASSERT(thread->schedLevel == 0);
+
+    delete io;
+}
@@ -0,0 +1,75 @@
+// mlfq.h
+//	Data structures for a multi-level feedback queue scheduler.
+//
+//	Threads are not given priorities; instead, the scheduler works
+//	out how each one behaves from how it has used the CPU:
+//
+//	   A thread starts at the highest of MLFQLevels levels, and
+//	   the scheduler always runs a thread from the highest level
+//	   that has any ready.
+//
+//	   A thread that runs for the whole quantum of its level (all
+//	   told, however many times it gives up the CPU in between) is
+//	   moved down a level.  The quantum doubles at each level down,
+//	   so CPU-bound threads end up running for longer between
+//	   context switches.
+//
+//	   A thread that blocks waiting for a device (the disk, the
+//	   console, or a mailbox) is moved up a level, so that I/O-bound
+//	   and interactive threads get the CPU soon after their I/O is
+//	   done.
+//
+//	   Every MLFQBoostTicks, every thread is put back at the highest
+//	   level, so that threads at the lower levels are not starved.
+//
+//	Selected with "-sched mlfq".
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef MLFQ_H
+#define MLFQ_H
+
+#include "copyright.h"
+#include "scheduler.h"
+#include "stats.h"
+
+const int MLFQLevels = 4;		// levels of queues
+const int MLFQBoostTicks = 5000;	// time between priority boosts
+
+// The following class defines a multi-level feedback queue scheduler.
+// Level l is kept in ready queue MLFQLevels - 1 - l of the Scheduler,
+// so that the highest level is the one run first.
+
+class MLFQScheduler : public Scheduler
+{
+public:
+  MLFQScheduler();
+
+  void ReadyToRun(Thread *thread); // put it on the queue for its level
+  void Print();                    // print the queues, with levels
+
+  bool TimerTick();                // has the running thread had its
+                                   // quantum, or is a higher level
+                                   // ready?
+  void WaitingForIO(Thread *thread); // move it up a level
+  void SelfTest();                 // test the demotions and boosts
+
+protected:
+  void Charge(Thread *thread, int ticks);
+  // move it down a level, if it has used
+  // its quantum
+
+private:
+  int Quantum(int level) { return TimerTicks << level; }
+  // ticks a thread may run at a level
+  void Boost();                    // put every thread at the top level
+  void CatchUp(Thread *thread);    // put a thread at the top level, if
+                                   // it has missed a boost
+
+  int numBoosts;                   // priority boosts so far
+  int lastBoost;                   // when the last one was
+};
+
+#endif // MLFQ_H
@@ -11,8 +11,8 @@
 //	end up calling FindNextToRun(), and that would put us in an
 //	infinite loop.
 //
-// 	Very simple implementation -- no priorities, straight FIFO.
-//	Might need to be improved in later assignments.
+// 	Threads are run in order of priority, and in FIFO order among
+//	threads of the same priority.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation
@@ -23,49 +23,84 @@
 #include "scheduler.h"
 #include "main.h"
 
+static const char *policyNames[] = {"priority", "mlfq", "cfs", "edf"};
+
 //----------------------------------------------------------------------
 // Scheduler::Scheduler
 // 	Initialize the list of ready but not running threads.
 //	Initially, no ready threads.
 //----------------------------------------------------------------------
-//lab8
-int compare(Thread *x, Thread *y)
+
+Scheduler::Scheduler()
 {
-    if (x->getPriority() > y->getPriority())
+    for (int p = 0; p < NumPriorities; p++)
     {
-        return -1;
+        readyList[p] = new List<Thread *>;
     }
-    else if (x->getPriority() == y->getPriority())
-    {
-        return 0;
-    }
-    else
+    readyMask = 0;
+    toBeDestroyed = NULL;
+    chargedTicks = 0;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::~Scheduler
+// 	De-allocate the list of ready threads.
+//----------------------------------------------------------------------
+
+Scheduler::~Scheduler()
+{
+    for (int p = 0; p < NumPriorities; p++)
     {
-        return 1;
+        delete readyList[p];
     }
 }
 
-Scheduler::Scheduler()
+//----------------------------------------------------------------------
+// Scheduler::PolicyNamed
+// 	Return the scheduling class with the given name.  Stop if there
+//	is no such class.
+//
+//	"name" -- "priority", "mlfq", "cfs" or "edf"
+//----------------------------------------------------------------------
+
+SchedPolicy
+Scheduler::PolicyNamed(char *name)
 {
-    //readyList = new List<Thread *>;
-    readyList = new SortedList<Thread *>(compare); // lab8 priority
-    toBeDestroyed = NULL;
+    for (int i = 0; i < NumSchedPolicies; i++)
+    {
+        if (strcmp(name, policyNames[i]) == 0)
+        {
+            return (SchedPolicy)i;
+        }
+    }
+    cerr << "Unknown scheduling class " << name << "\n";
+    ASSERTNOTREACHED();
+    return SchedPriority;
 }
 
 //----------------------------------------------------------------------
-// Scheduler::~Scheduler
-// 	De-allocate the list of ready threads.
+// Scheduler::Spin
+// 	Keep the CPU busy for about "ticks" of the running thread's own
+//	time, by turning interrupts off and on again, which advances the
+//	simulated time (and lets the timer preempt the thread).  For the
+//	SelfTests of the scheduling classes.
 //----------------------------------------------------------------------
 
-Scheduler::~Scheduler()
+void Scheduler::Spin(int ticks)
 {
-    delete readyList;
+    for (; ticks > 0; ticks -= SystemTick)
+    {
+        (void)kernel->interrupt->SetLevel(IntOff);
+        (void)kernel->interrupt->SetLevel(IntOn);
+    }
 }
 
 //----------------------------------------------------------------------
 // Scheduler::ReadyToRun
 // 	Mark a thread as ready, but not running.
-//	Put it on the ready list, for later scheduling onto the CPU.
+//	Put it on the ready list, for later scheduling onto the CPU:
+//	at the end of the queue for its priority, behind any other
+//	threads of the same priority.
 //
 //	"thread" is the thread to be put on the ready list.
 //----------------------------------------------------------------------
@@ -76,13 +111,87 @@ void Scheduler::ReadyToRun(Thread *thread)
     DEBUG(dbgThread, "Putting thread on ready list: " << thread->getName());
 
     thread->setStatus(READY);
-    //readyList->Append(thread);
-    readyList->Insert(thread);
+    Append(thread, thread->getPriority());
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Append
+// 	Put a thread at the end of one of the ready queues.
+//
+//	"thread" is the thread to be put on the ready list.
+//	"queue" is the queue, from 0 to NumPriorities - 1; the higher
+//		queues are run first
+//----------------------------------------------------------------------
+
+void Scheduler::Append(Thread *thread, int queue)
+{
+    ASSERT(queue >= 0 && queue < NumPriorities);
+    readyList[queue]->Append(thread);
+    readyMask |= 1U << queue;
+}
+
+//----------------------------------------------------------------------
+// HighestBit
+// 	Return the number of the highest bit set in a word, which must
+//	not be 0.
+//----------------------------------------------------------------------
+
+static int
+HighestBit(unsigned int mask)
+{
+#ifdef __GNUC__
+    return 31 - __builtin_clz(mask); // a single instruction
+#else
+    int bit = 0;
+
+    while ((mask >>= 1) != 0)
+    {
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+//----------------------------------------------------------------------
+// Scheduler::HighestReady
+// 	Return the highest ready queue that has any threads on it, or -1
+//	if none has.
+//----------------------------------------------------------------------
+
+int Scheduler::HighestReady()
+{
+    return (readyMask == 0) ? -1 : HighestBit(readyMask);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::RemoveHighest
+// 	Take the thread at the front of the highest ready queue that has
+//	any off it, and return it.  If there are no ready threads, return
+//	NULL.
+//----------------------------------------------------------------------
+
+Thread *
+Scheduler::RemoveHighest()
+{
+    int queue = HighestReady();
+    Thread *thread;
+
+    if (queue < 0)
+    {
+        return NULL;
+    }
+    thread = readyList[queue]->RemoveFront();
+    if (readyList[queue]->IsEmpty())
+    {
+        readyMask &= ~(1U << queue);
+    }
+    return thread;
 }
 
 //----------------------------------------------------------------------
 // Scheduler::FindNextToRun
-// 	Return the next thread to be scheduled onto the CPU.
+// 	Return the next thread to be scheduled onto the CPU: the one at
+//	the front of the queue for the highest priority that has any.
 //	If there are no ready threads, return NULL.
 // Side effect:
 //	Thread is removed from the ready list.
@@ -93,14 +202,37 @@ Scheduler::FindNextToRun()
 {
     ASSERT(kernel->interrupt->getLevel() == IntOff);
 
-    if (readyList->IsEmpty())
-    {
-        return NULL;
-    }
-    else
-    {
-        return readyList->RemoveFront();
-    }
+    return RemoveHighest();
+}
+
+//----------------------------------------------------------------------
+// Scheduler::RunningTicks
+// 	Return how long the running thread has run since it was last
+//	charged for its time, not counting any time the machine spent
+//	idle.
+//----------------------------------------------------------------------
+
+int Scheduler::RunningTicks()
+{
+    Statistics *stats = kernel->stats;
+
+    return stats->totalTicks - stats->idleTicks - chargedTicks;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Account
+// 	Charge the running thread for the time it has run since it was
+//	last charged, so that the scheduling class can decide where it
+//	goes next.  Done when it gives up the CPU, before it is put back
+//	on the ready list.
+//----------------------------------------------------------------------
+
+void Scheduler::Account()
+{
+    int ticks = RunningTicks();
+
+    Charge(kernel->currentThread, ticks);
+    chargedTicks += ticks;
 }
 
 //----------------------------------------------------------------------
@@ -141,6 +273,12 @@ void Scheduler::Run(Thread *nextThread, bool finishing)
     oldThread->CheckOverflow(); // check if the old thread
                                 // had an undetected stack overflow
 
+    Account(); // for the time oldThread has run
+    if (finishing)
+    {
+        Finishing(oldThread);
+    }
+
     kernel->currentThread = nextThread; // switch to the next thread
     nextThread->setStatus(RUNNING);     // nextThread is now running
 
@@ -196,6 +334,9 @@ void Scheduler::CheckToBeDestroyed()
 void Scheduler::Print()
 {
     cout << "Ready list contents:\n";
-    readyList->Apply(ThreadPrint);
+    for (int p = NumPriorities - 1; p >= 0; p--)
+    {
+        readyList[p]->Apply(ThreadPrint);
+    }
 }
 
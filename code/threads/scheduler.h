@@ -12,35 +12,103 @@
 #include "copyright.h"
 #include "list.h"
 #include "thread.h"
+#include <limits.h>
+
+// The scheduling classes: how the scheduler picks the next thread.
+
+enum SchedPolicy { SchedPriority,	// highest priority first
+		   SchedMLFQ,		// multi-level feedback queues
+					// (see mlfq.h)
+		   SchedCFS,		// fair shares of the CPU
+					// (see cfs.h)
+		   SchedEDF,		// earliest deadline first, for
+					// real-time threads (see edf.h)
+		   NumSchedPolicies
+};
 
 // The following class defines the scheduler/dispatcher abstraction --
 // the data structures and operations needed to keep track of which
 // thread is running, and which threads are ready but not running.
+//
+// The ready threads are kept in a FIFO queue for each priority, with
+// a bitmap of the queues that aren't empty, so that putting a thread on
+// the ready list and finding the next one to run each take constant
+// time, however many threads are ready.
+//
+// Other scheduling classes are subclasses, which decide which queue a
+// thread goes on, when it should be preempted, and so on.
 
 class Scheduler
 {
 public:
-  Scheduler();  // Initialize list of ready threads
-  ~Scheduler(); // De-allocate ready list
+  Scheduler();          // Initialize list of ready threads
+  virtual ~Scheduler(); // De-allocate ready list
+
+  static SchedPolicy PolicyNamed(char *name);
+  // the scheduling class with a given name
 
-  void ReadyToRun(Thread *thread);
+  virtual void ReadyToRun(Thread *thread);
   // Thread can be dispatched.
-  Thread *FindNextToRun(); // Dequeue first thread on the ready
-                           // list, if any, and return thread.
+  virtual Thread *FindNextToRun(); // Dequeue first thread on the ready
+                                   // list, if any, and return thread.
   void Run(Thread *nextThread, bool finishing);
   // Cause nextThread to start running
   void CheckToBeDestroyed(); // Check if thread that had been
                              // running needs to be deleted
-  void Print();              // Print contents of ready list
+  virtual void Print();      // Print contents of ready list
+
+  void Account(); // Charge the running thread for the time
+                  // it has run since it was last charged
+
+  virtual bool TimerTick() { return TRUE; }
+  // Called on each timer interrupt; should
+  // the running thread be preempted?
+  virtual void WaitingForIO(Thread *thread) {}
+  // The running thread is blocking on a
+  // device (called from Thread::Sleep)
+
+  virtual bool SetRealTime(Thread *thread, int period, int budget,
+                           int deadline) { return FALSE; }
+  // Make a thread real-time (see edf.h);
+  // FALSE if it can't be
+  virtual void WaitForNextPeriod() {}
+  // The running real-time thread's job is done
+  virtual int NextRelease() { return INT_MAX; }
+  // When the timer next makes a thread
+  // ready, or INT_MAX if it never will
+
+  virtual void SelfTest() {}
+  // Test the scheduling class; the tests of
+  // the default one are in class Thread
+  static void Spin(int ticks);
+  // Keep the CPU busy, for SelfTests
+
+protected:
+  virtual void Charge(Thread *thread, int ticks) {}
+  // The thread has just run for "ticks"
+  virtual void Finishing(Thread *thread) {}
+  // The thread is about to be destroyed
+  int RunningTicks();
+  // how long the running thread has run since
+  // it was last charged
+
+  void Append(Thread *thread, int queue);
+  // put a thread at the end of a ready queue
+  int HighestReady();
+  // the highest ready queue that isn't empty,
+  // or -1 if there are no ready threads
+  Thread *RemoveHighest(); // the thread at the front of it, or NULL
 
-  // SelfTest for scheduler is implemented in class Thread
+  List<Thread *> *readyList[NumPriorities];
+                         // queues of threads that are ready to
+                         // run, but not running, by priority
+  unsigned int readyMask; // bit p is set if readyList[p] isn't empty
 
 private:
-  //List<Thread *> *readyList; // queue of threads that are ready to run,
-                             // but not running
-  SortedList<Thread *> *readyList; // lab8 new readyList
   Thread *toBeDestroyed; // finishing thread to be destroyed
                          // by the next thread that runs
+  int chargedTicks;      // non-idle ticks when the running thread
+                         // was last charged
 };
 
 #endif // SCHEDULER_H
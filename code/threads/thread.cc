@@ -21,9 +21,6 @@
 #include "switch.h"
 #include "synch.h"
 #include "sysdep.h"
-// thread setting
-static int threadId[MAX_THREAD] = {0};
-static int threadNum = 0;
 // this is put at the top of the execution stack, for detecting stack overflows
 const int STACK_FENCEPOST = 0xdedbeef;
 
@@ -92,57 +89,28 @@ void consumer(int tid)
 
 Thread::Thread(char *threadName)
 {
-    // lab8
-    if (++threadNum > MAX_THREAD)
-    {
-        DEBUG('t', "The numbers of current threads extand maximum \n ");
-        threadNum--;
-        return;
-    }
-
-    for (int count = 0; count < MAX_THREAD; count++)
-    {
-        if (threadId[count] == 0)
-        {
-            setTid(count);
-            threadId[count] = 1;
-            break;
-        }
-    }
-
-    name = threadName;
-    stackTop = NULL;
-    stack = NULL;
-    status = JUST_CREATED;
-    for (int i = 0; i < MachineStateSize; i++)
-    {
-        machineState[i] = NULL; // not strictly necessary, since
-                                // new thread ignores contents
-                                // of machine registers
-    }
-    space = NULL;
+    Init(threadName, 0, 0); // the lowest priority
 }
+
 // lab8 for priority
 Thread::Thread(char *threadName, int priority, int uid)
 {
-    // check thread number
-    if (++threadNum > MAX_THREAD)
-    {
-        DEBUG('t', "The numbers of current threads extand maximum \n ");
-        threadNum--;
-        return;
-    }
-    // init thread in threadId
-    for (int count = 0; count < MAX_THREAD; count++)
-    {
-        if (threadId[count] == 0)
-        {
-            setTid(count);
-            threadId[count] = 1;
-            break;
-        }
-    }
+    Init(threadName, priority, uid);
+}
 
+//----------------------------------------------------------------------
+// Thread::Init
+// 	Initialize a thread control block, for the constructors: give
+//	the thread a tid, from the kernel's thread table.
+//
+//	"threadName" is an arbitrary string, useful for debugging.
+//	"priority" is its priority, from 0 to NumPriorities - 1
+//	"uid" is the user it runs for
+//----------------------------------------------------------------------
+
+void Thread::Init(char *threadName, int priority, int uid)
+{
+    setTid(kernel->threads->Add(this));
     setUid(uid);
     setPriority(priority);
 
@@ -157,6 +125,13 @@ Thread::Thread(char *threadName, int priority, int uid)
                                 // of machine registers
     }
     space = NULL;
+    callNode = NULL;
+    schedLevel = 0;
+    schedTicks = 0;
+    schedBoost = 0;
+    vruntime = 0;
+    rtTask = NULL;
+    waitingForIO = FALSE;
 }
 
 //----------------------------------------------------------------------
@@ -173,12 +148,10 @@ Thread::Thread(char *threadName, int priority, int uid)
 
 Thread::~Thread()
 {
-    // lab8
-    threadNum--;
-    threadId[getTid()] = 0;
-
     DEBUG(dbgThread, "Deleting thread: " << name);
 
+    kernel->threads->Remove(tid);
+
     ASSERT(this != kernel->currentThread);
     if (stack != NULL)
         DeallocBoundedArray((char *)stack, StackSize * sizeof(int));
@@ -320,6 +293,7 @@ void Thread::Yield()
 
     DEBUG(dbgThread, "Yielding thread: " << name);
 
+    kernel->scheduler->Account(); // before it goes back on the ready list
     nextThread = kernel->scheduler->FindNextToRun();
     if (nextThread != NULL)
     {
@@ -359,6 +333,10 @@ void Thread::Sleep(bool finishing)
     DEBUG(dbgThread, "Sleeping thread: " << name);
 
     status = BLOCKED;
+    if (waitingForIO)
+    {
+        kernel->scheduler->WaitingForIO(this); // blocked on a device
+    }
     while ((nextThread = kernel->scheduler->FindNextToRun()) == NULL)
         kernel->interrupt->Idle(); // no one to run, wait for an interrupt
 
@@ -475,6 +453,7 @@ void Thread::StackAllocate(VoidFunctionPtr func, void *arg)
 }
 
 #include "machine.h"
+#include "timing.h"
 
 //----------------------------------------------------------------------
 // Thread::SaveUserState
@@ -497,13 +476,19 @@ void Thread::SaveUserState()
 //
 //	Note that a user program thread has *two* sets of CPU registers --
 //	one for its state while executing user code, one for its state
-//	while executing kernel code.  This routine restores the former.
+//	while executing kernel code.  This routine restores the former,
+//	and starts the timing model's pipeline (see timing.h) empty.
 //----------------------------------------------------------------------
 
 void Thread::RestoreUserState()
 {
     for (int i = 0; i < NumTotalRegs; i++)
         kernel->machine->WriteRegister(i, userRegisters[i]);
+    if (kernel->machine->timing != NULL)
+    {
+        kernel->machine->timing->Drain(); // a load by the thread before
+                                          // can't stall this one
+    }
 }
 
 //----------------------------------------------------------------------
@@ -565,7 +550,7 @@ void selfTestForArttibute()
 void selfTestForConcurrency()
 {
     DEBUG(dbgThread, "Entering SelfTestForConcurrency\nname-tid-uid-priority");
-    for (int count = 0; count < MAX_THREAD + 5; count++)
+    for (int count = 0; count < 133; count++) // past the old limit of 128
     {
         Thread *t = new Thread("init thread", 0, 5446);
         ThreadPrint(t);
@@ -629,6 +614,7 @@ void Thread::setUid(int uid)
 
 void Thread::setPriority(int priority)
 {
+    ASSERT(priority >= 0 && priority < NumPriorities);
     this->priority = priority;
 }
 
@@ -639,7 +625,7 @@ int Thread::getTid()
 
 int Thread::getUid()
 {
-    return GetUid();
+    return this->uid;
 }
 
 int Thread::getPriority()
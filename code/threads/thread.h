@@ -44,8 +44,13 @@
 #include "machine.h"
 #include "addrspace.h"
 
-// thread settings
-#define MAX_THREAD 128
+class CallNode;
+class EDFTask;
+
+// Thread priorities run from 0 to NumPriorities - 1; the scheduler
+// runs ready threads of higher priority first.  There can be no more
+// priorities than bits in a word (see Scheduler::readyMask).
+const int NumPriorities = 32;
 
 
 // CPU register state to be saved on context switch.
@@ -110,6 +115,7 @@ public:
 
   void CheckOverflow(); // Check if thread stack has overflowed
   void setStatus(ThreadStatus st) { status = st; }
+  ThreadStatus getStatus() { return status; }
   char *getName() { return (name); }
   void Print() { cout << name <<'-'<< tid <<'-'<< uid <<'-'<< priority << endl; } // lab8 print more infomation
   void SelfTest();                                                                         // test whether thread impl is working
@@ -124,6 +130,8 @@ private:
   ThreadStatus status; // ready, running or blocked
   char *name;
 
+  void Init(char *threadName, int priority, int uid);
+  // Initialize a thread, for the constructors
   void StackAllocate(VoidFunctionPtr func, void *arg);
   // Allocate a stack for thread.
   // Used internally by Fork()
@@ -139,6 +147,8 @@ public:
   void RestoreUserState(); // restore user-level register state
 
   AddrSpace *space; // User code this thread is running.
+  CallNode *callNode; // Where the user code is in its call graph,
+                      // if it is being profiled (see profile.h)
 
   // lab8
 private:
@@ -153,6 +163,19 @@ public:
   int getTid();
   int getUid();
   int getPriority();
+
+  // State kept by the scheduling classes (see scheduler.h); public
+  // for notational convenience.
+public:
+  int schedLevel; // MLFQ: the queue it belongs on, 0 the highest
+  int schedTicks; // MLFQ: ticks it has run at that level;
+                  // CFS: ticks it has run in this turn
+  int schedBoost; // MLFQ: the last priority boost it has had
+  double vruntime; // CFS: ticks it has run, scaled by its share
+  EDFTask *rtTask; // EDF: its period, budget and deadline, if
+                   // it is a real-time thread
+  bool waitingForIO; // set around a wait for a device, so that
+                     // Sleep tells the scheduler if it blocks
 };
 
 // external function, dummy routine whose sole job is to call Thread::Print
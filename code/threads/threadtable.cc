@@ -0,0 +1,214 @@
+// threadtable.cc
+//	Routines to give out thread ids, and to find threads from them
+//	(see threadtable.h).
+//
+// 	These routines assume mutual exclusion is provided by the caller,
+//	as for the thread constructor and destructor.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "debug.h"
+#include "threadtable.h"
+
+const int SlotMask = MaxThreads - 1;		// the slot bits of a tid
+const int GenerationMask = (1 << (31 - TidSlotBits)) - 1;
+						// the generation bits, so
+						// that tids are never < 0
+
+//----------------------------------------------------------------------
+// ThreadTable::ThreadTable
+// 	Initialize an empty thread table, with every slot free.
+//----------------------------------------------------------------------
+
+ThreadTable::ThreadTable()
+{
+    slots = NULL;
+    size = 0;
+    numThreads = 0;
+    firstFree = lastFree = -1;
+    Grow();
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::~ThreadTable
+// 	De-allocate the table.  The threads themselves are not deleted.
+//----------------------------------------------------------------------
+
+ThreadTable::~ThreadTable()
+{
+    delete[] slots;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Grow
+// 	Double the number of slots (or make the first ones), and put the
+//	new ones on the free list, in order.  Stop if the table is already
+//	as large as it can be.
+//----------------------------------------------------------------------
+
+void ThreadTable::Grow()
+{
+    int newSize = (size == 0) ? ThreadTableInitialSize : size * 2;
+    ThreadSlot *newSlots;
+
+    if (size == MaxThreads)
+    {
+        cerr << "Too many threads: no more than " << MaxThreads << " at once\n";
+        ASSERTNOTREACHED();
+    }
+    if (newSize > MaxThreads)
+    {
+        newSize = MaxThreads;
+    }
+    newSlots = new ThreadSlot[newSize];
+    for (int i = 0; i < size; i++)
+    {
+        newSlots[i] = slots[i];
+    }
+    delete[] slots;
+    slots = newSlots;
+
+    for (int i = size; i < newSize; i++)
+    {
+        slots[i].generation = 0;
+        Free(i);
+    }
+    size = newSize;
+    DEBUG(dbgThread, "Thread table grown to " << size << " slots");
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Free
+// 	Put a slot at the end of the free list.
+//
+//	"slot" is the slot
+//----------------------------------------------------------------------
+
+void ThreadTable::Free(int slot)
+{
+    slots[slot].thread = NULL;
+    slots[slot].next = -1;
+    if (lastFree < 0)
+    {
+        firstFree = slot;
+    }
+    else
+    {
+        slots[lastFree].next = slot;
+    }
+    lastFree = slot;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Add
+// 	Give a new thread the slot at the front of the free list, growing
+//	the table if there are no free slots, and return its tid.
+//
+//	"thread" is the thread
+//----------------------------------------------------------------------
+
+int ThreadTable::Add(Thread *thread)
+{
+    int slot;
+
+    ASSERT(thread != NULL);
+    if (firstFree < 0)
+    {
+        Grow();
+    }
+    slot = firstFree;
+    firstFree = slots[slot].next;
+    if (firstFree < 0)
+    {
+        lastFree = -1;
+    }
+    slots[slot].thread = thread;
+    numThreads++;
+    return (slots[slot].generation << TidSlotBits) | slot;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Remove
+// 	Free the slot of a thread that is being deleted, moving on its
+//	generation so that the thread's tid is no longer found.
+//
+//	"tid" is the thread's tid
+//----------------------------------------------------------------------
+
+void ThreadTable::Remove(int tid)
+{
+    int slot = tid & SlotMask;
+
+    ASSERT(Lookup(tid) != NULL);
+    slots[slot].generation = (slots[slot].generation + 1) & GenerationMask;
+    Free(slot);
+    numThreads--;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Lookup
+// 	Return the thread with a tid, or NULL if the tid was never given
+//	out, or its thread has been deleted.
+//
+//	"tid" is the tid
+//----------------------------------------------------------------------
+
+Thread *
+ThreadTable::Lookup(int tid)
+{
+    int slot = tid & SlotMask;
+
+    if (tid < 0 || slot >= size || slots[slot].thread == NULL ||
+        slots[slot].generation != (tid >> TidSlotBits))
+    {
+        return NULL;
+    }
+    return slots[slot].thread;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::SelfTest
+//      Test whether this module is working: tids are found while their
+//	threads are in the table, and stale ones aren't; the table grows
+//	as needed.  Uses a table of its own, with made-up threads.
+//----------------------------------------------------------------------
+
+void ThreadTable::SelfTest()
+{
+    ThreadTable *table = new ThreadTable;
+    int num = ThreadTableInitialSize * 2 + 1; // enough to grow twice
+    int *tids = new int[num];
+    Thread *thread;
+    int stale;
+
+    for (int i = 0; i < num; i++)
+    {
+        tids[i] = table->Add((Thread *)(tids + i));
+        ASSERT(tids[i] == i); // first generation: tid is slot
+    }
+    ASSERT(table->NumThreads() == num);
+    for (int i = 0; i < num; i++)
+    {
+        ASSERT(table->Lookup(tids[i]) == (Thread *)(tids + i));
+    }
+
+    stale = tids[0];
+    table->Remove(stale);
+    ASSERT(table->Lookup(stale) == NULL);
+    thread = (Thread *)tids;
+    tids[0] = table->Add(thread); // a slot at the end, not slot 0
+    ASSERT(tids[0] != stale && table->Lookup(tids[0]) == thread);
+    ASSERT(table->Lookup(stale) == NULL);
+    ASSERT(table->Lookup(-1) == NULL);
+
+    for (int i = 0; i < num; i++)
+    {
+        table->Remove(tids[i]);
+    }
+    ASSERT(table->NumThreads() == 0);
+    delete[] tids;
+    delete table;
+}
@@ -0,0 +1,75 @@
+// threadtable.h
+//	Data structures to give each thread a thread id (tid), and to
+//	find a thread from its tid.
+//
+//	The table has a slot for each thread; a tid is the number of
+//	its thread's slot, plus a generation count in the high bits.
+//	The count goes up each time the slot is freed, so a tid left
+//	over from a thread that has been deleted doesn't find the
+//	thread that took its slot.  While their slots are in their first
+//	generation, the tids are simply 0, 1, 2, ...
+//
+//	Free slots are kept on a list, and given out in the order they
+//	were freed (so that a slot's generation count goes round as
+//	slowly as it can), so that giving out or taking back a tid
+//	takes constant time.  The table grows as needed, up to MaxThreads
+//	threads at a time.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef THREADTABLE_H
+#define THREADTABLE_H
+
+#include "copyright.h"
+
+class Thread;
+
+const int TidSlotBits = 16;			// bits of a tid for the slot
+const int MaxThreads = 1 << TidSlotBits;	// the most threads at once
+const int ThreadTableInitialSize = 128;		// slots to start with
+
+// The following class defines one slot of the thread table.
+//
+// This class is private to this module. Made public for notational
+// convenience.
+
+class ThreadSlot
+{
+public:
+  Thread *thread; // the thread, or NULL if the slot is free
+  int generation; // times the slot has been freed
+  int next;       // if free, the next free slot, or -1
+};
+
+// The following class defines the thread table.
+
+class ThreadTable
+{
+public:
+  ThreadTable();  // initialize an empty table
+  ~ThreadTable(); // de-allocate the table
+
+  int Add(Thread *thread); // give a thread a slot; return its tid
+  void Remove(int tid);    // free the slot of a thread being deleted
+  Thread *Lookup(int tid); // the thread with a tid, or NULL if
+                           // there is none (any more)
+
+  int NumThreads() { return numThreads; }
+  // how many threads there are
+
+  static void SelfTest(); // verify module is working
+
+private:
+  ThreadSlot *slots;  // the slots
+  int size;           // number of slots allocated
+  int numThreads;     // number of slots in use
+  int firstFree;      // the free slot to give out next, or -1
+  int lastFree;       // the free slot freed last, or -1
+
+  void Grow();        // double the number of slots
+  void Free(int slot); // put a slot at the end of the free list
+};
+
+#endif // THREADTABLE_H
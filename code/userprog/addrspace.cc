@@ -21,6 +21,8 @@
 #include "machine.h"
 #include "noff.h"
 
+static int nextSpaceId = 0; // the ASID to give the next address space
+
 //----------------------------------------------------------------------
 // SwapHeader
 // 	Do little endian to big endian conversion on the bytes in the
@@ -64,6 +66,7 @@ SwapHeader(NoffHeader *noffH)
 
 AddrSpace::AddrSpace()
 {
+    spaceId = nextSpaceId++;
     pageTable = new TranslationEntry[NumPhysPages];
     for (int i = 0; i < NumPhysPages; i++)
     {
@@ -77,6 +80,7 @@ AddrSpace::AddrSpace()
 
     // zero out the entire address space
     bzero(kernel->machine->mainMemory, MemorySize);
+    kernel->machine->FlushDecodeCache();
 }
 
 //----------------------------------------------------------------------
@@ -86,6 +90,8 @@ AddrSpace::AddrSpace()
 
 AddrSpace::~AddrSpace()
 {
+    if (kernel->machine->tlb != NULL)
+        kernel->machine->tlb->FlushSpace(spaceId);
     delete pageTable;
 }
 
@@ -131,10 +137,10 @@ bool AddrSpace::Load(char *fileName)
     numPages = divRoundUp(size, PageSize);
     size = numPages * PageSize;
 
-    ASSERT(numPages <= NumPhysPages); // check we're not trying
-                                      // to run anything too big --
-                                      // at least until we have
-                                      // virtual memory
+    ASSERT(numPages <= (unsigned int)NumPhysPages); // check we're not trying
+                                                    // to run anything too big --
+                                                    // at least until we have
+                                                    // virtual memory
 
     DEBUG(dbgAddr, "Initializing address space: " << numPages << ", " << size);
 
@@ -168,6 +174,10 @@ bool AddrSpace::Load(char *fileName)
     }
 #endif
 
+    // we wrote the code straight into mainMemory, behind the back
+    // of the simulator's decode cache
+    kernel->machine->FlushDecodeCache();
+
     delete executable; // close file
     return TRUE;       // success
 }
@@ -189,6 +199,8 @@ void AddrSpace::Execute()
     this->InitRegisters(); // set the initial register values
     this->RestoreState();  // load page table register
 
+    kernel->SaveSnapshot(this); // if we were asked to (-save)
+
     kernel->machine->Run(); // jump to the user progam
 
     ASSERTNOTREACHED(); // machine->Run never returns;
@@ -196,6 +208,74 @@ void AddrSpace::Execute()
                         // by doing the syscall "exit"
 }
 
+//----------------------------------------------------------------------
+// AddrSpace::Resume
+// 	Run a user program using the current thread, starting from the
+//	registers restored from a snapshot (see Kernel::RestoreSnapshot).
+//----------------------------------------------------------------------
+
+void AddrSpace::Resume()
+{
+    kernel->currentThread->space = this;
+
+    this->RestoreState(); // load page table register
+
+    kernel->machine->Run(); // jump back into the user progam
+
+    ASSERTNOTREACHED();
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::WriteSnapshot
+// 	Save the ASID and the page table to a snapshot file, followed by
+//	the contents of each physical page that it maps.
+//
+//	"fd" -- the snapshot file
+//----------------------------------------------------------------------
+
+void AddrSpace::WriteSnapshot(int fd)
+{
+    Machine *machine = kernel->machine;
+
+    WriteFile(fd, (char *)&spaceId, sizeof(spaceId));
+    WriteFile(fd, (char *)&numPages, sizeof(numPages));
+    WriteFile(fd, (char *)pageTable, numPages * sizeof(TranslationEntry));
+    for (unsigned int i = 0; i < numPages; i++)
+        if (pageTable[i].valid)
+            WriteFile(fd, &machine->mainMemory[pageTable[i].physicalPage * PageSize],
+                      PageSize);
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::ReadSnapshot
+// 	Restore the ASID and the page table from a snapshot file, and load
+//	each page it maps straight into physical memory.
+//
+//	"fd" -- the snapshot file
+//----------------------------------------------------------------------
+
+void AddrSpace::ReadSnapshot(int fd)
+{
+    Machine *machine = kernel->machine;
+
+    Read(fd, (char *)&spaceId, sizeof(spaceId));
+    if (nextSpaceId <= spaceId)
+        nextSpaceId = spaceId + 1;
+    Read(fd, (char *)&numPages, sizeof(numPages));
+    ASSERT(numPages <= (unsigned int)NumPhysPages);
+    Read(fd, (char *)pageTable, numPages * sizeof(TranslationEntry));
+    for (unsigned int i = 0; i < numPages; i++)
+        if (pageTable[i].valid)
+        {
+            ASSERT(pageTable[i].physicalPage < NumPhysPages);
+            Read(fd, &machine->mainMemory[pageTable[i].physicalPage * PageSize],
+                 PageSize);
+        }
+
+    // as in Load, we wrote the code straight into mainMemory
+    machine->FlushDecodeCache();
+}
+
 //----------------------------------------------------------------------
 // AddrSpace::InitRegisters
 // 	Set the initial values for the user-level register set.
@@ -248,13 +328,16 @@ void AddrSpace::SaveState()
 // 	On a context switch, restore the machine state so that
 //	this address space can run.
 //
-//      For now, tell the machine where to find the page table.
+//      For now, tell the machine where to find the page table, and
+//	which TLB entries are ours.  The TLB needn't be flushed.
 //----------------------------------------------------------------------
 
 void AddrSpace::RestoreState()
 {
     kernel->machine->pageTable = pageTable;
     kernel->machine->pageTableSize = numPages;
+    kernel->machine->spaceId = spaceId;
+    kernel->machine->FlushSoftTLB();
 }
 
 //----------------------------------------------------------------------
@@ -302,7 +385,7 @@ AddrSpace::Translate(unsigned int vaddr, unsigned int *paddr, int isReadWrite)
 
     *paddr = pfn * PageSize + offset;
 
-    ASSERT((*paddr < MemorySize));
+    ASSERT((*paddr < (unsigned int)MemorySize));
 
     // cerr << " -- AddrSpace::Translate(): vaddr: " << vaddr <<
     //   ", paddr: " << *paddr << "\n";
@@ -31,6 +31,12 @@ class AddrSpace {
 					// assumes the program has already
                                         // been loaded
 
+    void Resume();			// Run a program restored from a
+					// snapshot, where it left off
+
+    void WriteSnapshot(int fd);		// Save/restore the page table, and
+    void ReadSnapshot(int fd);		// the pages it maps, for snapshots
+
     void SaveState();			// Save/restore address space-specific
     void RestoreState();		// info on a context switch 
 
@@ -44,6 +50,8 @@ class AddrSpace {
 					// for now!
     unsigned int numPages;		// Number of pages in the virtual 
 					// address space
+    int spaceId;			// Tags our entries in the TLB (the
+					// ASID)
 
     void InitRegisters();		// Initialize user-level CPU registers,
 					// before jumping to user code
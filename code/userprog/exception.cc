@@ -25,6 +25,33 @@
 #include "main.h"
 #include "syscall.h"
 #include "ksyscall.h"
+
+//----------------------------------------------------------------------
+// TLBMissHandler
+// 	Load the translation of a virtual address that missed in the TLB
+//	from the running address space's page table.  The TLB picks the
+//	entry to replace, by the policy given with -tlbpolicy.  An
+//	address that isn't in the page table is fatal, since returning
+//	would only run the faulting instruction again.
+//
+//	"virtAddr" -- the address that missed
+//----------------------------------------------------------------------
+
+static void
+TLBMissHandler(int virtAddr)
+{
+	Machine *machine = kernel->machine;
+	unsigned int vpn = (unsigned)virtAddr / PageSize;
+
+	if (vpn >= machine->pageTableSize || !machine->pageTable[vpn].valid)
+	{ // not a legal address: retrying would only miss again
+		cerr << "TLB miss on invalid virtual address " << virtAddr << "\n";
+		ASSERTNOTREACHED();
+	}
+	DEBUG(dbgAddr, "TLB miss on page " << vpn << " of space " << machine->spaceId);
+	machine->tlb->Load(machine->spaceId, &machine->pageTable[vpn]);
+}
+
 //----------------------------------------------------------------------
 // ExceptionHandler
 // 	Entry point into the Nachos kernel.  Called when a user program
@@ -47,123 +74,6 @@
 //	"which" is the kind of exception.  The list of possible exceptions
 //	is in machine.h.
 //----------------------------------------------------------------------
-int pointer = 0;
-void SimpleTLBMissHandler(int virtAddr)
-{
-	unsigned int vpn;
-	vpn = (unsigned)virtAddr / PageSize;
-	// 这里假设tlb仅有两个位置，用于测试tlb功能
-	DEBUG('a', ">>>>>>>>add page to tlb>>>>>>>>>>>>");
-	kernel->machine->tlb[pointer] = kernel->machine->pageTable[vpn];
-	pointer = pointer ? 0 : 1;
-}
-
-void TLBMissHandler(int virtAddr)
-{
-
-	unsigned int vpn = (unsigned)virtAddr / PageSize;
-	unsigned int tlbExchangeIndex = -1;
-
-	// 如果TLB为空，直接插入
-	for (int i = 0; i < TLBSize; ++i)
-	{
-		if (!kernel->machine->tlb[i].valid)
-		{
-			tlbExchangeIndex = i;
-			break;
-		}
-	}
-	// tlb满,使用fifo、lru、NRU置换算法
-	if (tlbExchangeIndex == -1)
-	{
-		DEBUG('a', "tlb get max size.\n");
-
-#ifdef TLB_FIFO
-		tlbExchangeIndex = TLBSize - 1;
-		// 将后n-1个元素向前挪动一个单位，并将新元素插入队尾
-		for (int i = 0; i < TLBSize - 1; ++i)
-		{
-			kernel->machine->tlb[i] = kernel->machine->tlb[i + 1];
-		}
-#endif
-
-#ifdef TLB_LRU
-		unsigned int min = __INT_MAX__;
-		// 找lastVisitedTime最小的元素
-		for (int i = 0; i < TLBSize; ++i)
-		{
-			if (kernel->machine->tlb[i].lastVisitedTime < min)
-			{
-				min = kernel->machine->tlb[i].lastVisitedTime;
-				tlbExchangeIndex = i;
-			}
-		}
-#endif
-
-#ifdef TLB_NRU
-		while (tlbExchangeIndex == -1)
-		{
-			// 选择遇到的第一个(A=0, M=0)页，则进行置换
-			for (int i = 0; i < TLBSize; ++i)
-			{
-				if (!kernel->machine->tlb[i].use && !kernel->machine->tlb[i].dirty)
-				{
-					tlbExchangeIndex = i;
-					break;
-				}
-			}
-			// 如果第1步失败，则重新扫描，查找(A=0, M=1)页,
-			// 选择遇到的第一个这样的页则置换。在这个扫描过程中，对每个跳过的页，把它的使用位设置成0
-			// 重复这个过程直到找到可以替换的页面
-			if (tlbExchangeIndex == -1)
-			{
-				for (int i = 0; i < TLBSize; ++i)
-				{
-					if (!kernel->machine->tlb[i].use && kernel->machine->tlb[i].dirty)
-					{
-						tlbExchangeIndex = i;
-						break;
-					}
-					else
-					{
-						kernel->machine->tlb[i].use = false;
-					}
-				}
-			}
-		}
-#endif
-	}
-	cout << "--------------------缺页中断处理开始--------------------\n\n";
-	cout << "TLB before replacement:\n";
-	for (int i = 0; i < TLBSize; ++i)
-	{
-		cout << "tlb[" << i << "] valid :" << kernel->machine->tlb[i].valid << " lastVisitedTime: " << kernel->machine->tlb[i].lastVisitedTime << " use: " << kernel->machine->tlb[i].use << " dirty: " << kernel->machine->tlb[i].dirty << " virtualPage: " << kernel->machine->tlb[i].virtualPage << " physicalPage: " << kernel->machine->tlb[i].physicalPage << "\n\n";
-	}
-	cout << "Replacement: "
-		 << "tlb[" << tlbExchangeIndex << "] has been exchanged by PageTable[" << vpn << "]\n";
-	kernel->machine->tlb[tlbExchangeIndex] = kernel->machine->pageTable[vpn]; // 将页表中的页面加载到tlb中
-	cout << "PageTable[" << vpn << "]Info: use: " << kernel->machine->pageTable[vpn].use << " dirty: " << kernel->machine->pageTable[vpn].dirty << " virtualPage: " << kernel->machine->pageTable[vpn].virtualPage << " physicalPage: " << kernel->machine->pageTable[vpn].physicalPage << "\n\n"
-		 << endl;
-#ifdef TLB_NRU
-	// 随机修改dirty位，模拟写入修改，测试nru算法
-	int tf = rand() % 2;
-	if (tf == 1)
-	{
-		kernel->machine->tlb[tlbExchangeIndex].dirty = TRUE;
-	}
-	else
-	{
-		kernel->machine->tlb[tlbExchangeIndex].dirty = FALSE;
-	}
-#endif
-	cout << "TLB after replacement:\n";
-	for (int i = 0; i < TLBSize; ++i)
-	{
-		cout << "tlb[" << i << "] valid :" << kernel->machine->tlb[i].valid << " lastVisitedTime: " << kernel->machine->tlb[i].lastVisitedTime << " use: " << kernel->machine->tlb[i].use << " dirty: " << kernel->machine->tlb[i].dirty << " virtualPage: " << kernel->machine->tlb[i].virtualPage << " physicalPage: " << kernel->machine->tlb[i].physicalPage << "\n\n";
-	}
-	cout << "--------------------缺页中断处理结束--------------------\n\n";
-}
-
 void ExceptionHandler(ExceptionType which)
 {
 
@@ -175,7 +85,6 @@ void ExceptionHandler(ExceptionType which)
 
 	case PageFaultException:
 #ifdef USE_TLB
-		// SimpleTLBMissHandler(kernel->machine->ReadRegister(BadVAddrReg));
 		TLBMissHandler(kernel->machine->ReadRegister(BadVAddrReg));
 #endif
 		break;
@@ -52,45 +52,54 @@ int SysDiv(int op1, int op2)
 
 int SysWrite(int Addr, int Count, int FileID)
 {
-  int ch;
-  int i = 0;
-  while (i < Count)
+  char *buffer = new char[PageSize];
+  int done = 0;
+  int n, copied;
+
+  while (done < Count)
   {
-    kernel->machine->ReadMem(Addr, 1, &ch);
-    write(FileID, (char *)&ch, 1);
-    Addr++;
-    i++;
+    n = Count - done;
+    if (n > PageSize)
+      n = PageSize;
+    copied = kernel->machine->CopyIn(Addr + done, buffer, n);
+    write(FileID, buffer, copied);
+    done += copied;
+    if (copied < n)
+      break;
   }
-  return i;
+  delete[] buffer;
+  return done;
 }
 
 int SysRead(int Addr, int Count, int FileID)
 {
-  int ch;
-  int i = 0;
-  while (i < Count)
+  char *buffer = new char[PageSize];
+  int done = 0;
+  int n, copied;
+
+  while (done < Count)
   {
-    read(FileID, &ch, 1);
-    kernel->machine->WriteMem(Addr, 1, ch);
-    Addr++;
-    i++;
-    write(FileID, (char *)&ch, 1);
+    n = Count - done;
+    if (n > PageSize)
+      n = PageSize;
+    n = read(FileID, buffer, n);
+    if (n <= 0)
+      break;
+    copied = kernel->machine->CopyOut(Addr + done, buffer, n);
+    write(FileID, buffer, copied); // echo what was read
+    done += copied;
+    if (copied < n)
+      break;
   }
-  return i;
+  delete[] buffer;
+  return done;
 }
 
 int SysExec(int Addr)
 {
-  int count = 0;
-  int ch;
   char cmd[60];
-  do
-  {
-    kernel->machine->ReadMem(Addr, 1, &ch);
-    Addr++;
-    cmd[count] = (char)ch;
-  } while (ch != '\0' && count++ < 59);
-  cmd[count] = '\0';
+  if (kernel->machine->StringIn(Addr, cmd, sizeof(cmd)) < 0)
+    return -1;
   pid_t child;
   child = vfork();
   if (child == 0)
@@ -8,6 +8,7 @@
 
 #include "copyright.h"
 #include "synchconsole.h"
+#include "main.h"
 
 //----------------------------------------------------------------------
 // SynchConsoleInput::SynchConsoleInput
@@ -47,7 +48,9 @@ SynchConsoleInput::GetChar()
     char ch;
 
     lock->Acquire();
+    kernel->currentThread->waitingForIO = TRUE;
     waitFor->P();	// wait for EOF or a char to be available.
+    kernel->currentThread->waitingForIO = FALSE;
     ch = consoleInput->GetChar();
     lock->Release();
     return ch;
@@ -102,7 +105,9 @@ SynchConsoleOutput::PutChar(char ch)
 {
     lock->Acquire();
     consoleOutput->PutChar(ch);
+    kernel->currentThread->waitingForIO = TRUE;
     waitFor->P();
+    kernel->currentThread->waitingForIO = FALSE;
     lock->Release();
 }
 
@@ -0,0 +1,536 @@
+/* noff2c.cc
+ *
+ * This program reads in a NOFF format file, and outputs C code for the
+ * basic blocks of its code segment, for Nachos to run in place of
+ * simulating them (see code/machine/native.h):
+ *
+ *	noff2c [-ps <page size>] matmult.noff matmult.c
+ *	gcc -m32 -O2 -shared -fPIC -I../machine matmult.c -o matmult.so
+ *	nachos -native matmult.so -x matmult.noff
+ *
+ * A block is compiled for each place the program can be seen to go to:
+ * the start of the code, the targets of branches and jumps, the
+ * instruction after the delay slot of each of them (where calls return
+ * to, and untaken branches fall through to), and the instruction after
+ * each system call.  Each block is cut up exactly as the block engine
+ * (code/machine/blocksim.cc) would, for the page size Nachos is to be
+ * run with (-ps); Nachos checks that it was.
+ *
+ * The instructions are decoded with the simulator's own tables, so
+ * this has to be built with the Nachos sources at hand.
+ *
+ * Copyright (c) 1992-1993 The Regents of the University of California.
+ * All rights reserved.  See copyright.h for copyright notice and limitation
+ * of liability and disclaimer of warranty provisions.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#define MAIN
+#include "copyright.h"
+#undef MAIN
+
+#include "noff.h"
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef TRUE
+#define TRUE true
+#define FALSE false
+#endif
+
+#include "mipssim.h"
+
+/* what we know about the delayed load pending before an instruction,
+ * besides the register it is to */
+#define PendingUnknown	-1	/* whatever was pending at the block's start */
+#define PendingNone	-2	/* nothing */
+
+FILE *out;
+
+/****************************************************************/
+/* Routines for converting words to the host's format from the
+ * simulated machine's format of little endian.  As in coff2noff.
+ */
+
+unsigned int
+WordToHost(unsigned int word) {
+#ifdef HOST_IS_BIG_ENDIAN
+	 register unsigned long result;
+	 result = (word >> 24) & 0x000000ff;
+	 result |= (word >> 8) & 0x0000ff00;
+	 result |= (word << 8) & 0x00ff0000;
+	 result |= (word << 24) & 0xff000000;
+	 return result;
+#else
+	 return word;
+#endif /* HOST_IS_BIG_ENDIAN */
+}
+
+static void
+SwapHeader (NoffHeader *noffH)
+{
+    noffH->noffMagic = WordToHost(noffH->noffMagic);
+    noffH->code.size = WordToHost(noffH->code.size);
+    noffH->code.virtualAddr = WordToHost(noffH->code.virtualAddr);
+    noffH->code.inFileAddr = WordToHost(noffH->code.inFileAddr);
+}
+
+/****************************************************************/
+
+/* read and check for error */
+void Read(int fd, char *buf, int nBytes)
+{
+    if (read(fd, buf, nBytes) != nBytes) {
+        fprintf(stderr, "File is too short\n");
+	exit(1);
+    }
+}
+
+/* decode an instruction, as Instruction::Decode does */
+void Decode(unsigned int value, Instruction *instr)
+{
+    OpInfo *opPtr;
+
+    instr->value = value;
+    instr->rs = (value >> 21) & 0x1f;
+    instr->rt = (value >> 16) & 0x1f;
+    instr->rd = (value >> 11) & 0x1f;
+    opPtr = &opTable[(value >> 26) & 0x3f];
+    instr->opCode = opPtr->opCode;
+    if (opPtr->format == IFMT) {
+	instr->extra = value & 0xffff;
+	if (instr->extra & 0x8000)
+	    instr->extra |= 0xffff0000;
+    } else if (opPtr->format == RFMT)
+	instr->extra = (value >> 6) & 0x1f;
+    else
+	instr->extra = value & 0x3ffffff;
+    if (opPtr->opCode == SPECIAL)
+	instr->opCode = specialTable[value & 0x3f];
+    else if (opPtr->opCode == BCOND) {
+	switch (value & 0x1f0000) {
+	  case 0:		instr->opCode = OP_BLTZ; break;
+	  case 0x10000:		instr->opCode = OP_BGEZ; break;
+	  case 0x100000:	instr->opCode = OP_BLTZAL; break;
+	  case 0x110000:	instr->opCode = OP_BGEZAL; break;
+	  default:		instr->opCode = OP_UNIMP; break;
+	}
+    }
+}
+
+/* is the instruction a branch or a jump, with a delay slot? */
+int IsBranch(Instruction *instr)
+{
+    switch (instr->opCode) {
+      case OP_BEQ: case OP_BNE: case OP_BLEZ: case OP_BGTZ:
+      case OP_BLTZ: case OP_BGEZ: case OP_BLTZAL: case OP_BGEZAL:
+      case OP_J: case OP_JAL: case OP_JR: case OP_JALR:
+	return 1;
+      default:
+	return 0;
+    }
+}
+
+/* is it a load, leaving a delayed load pending? */
+int IsLoad(Instruction *instr)
+{
+    switch (instr->opCode) {
+      case OP_LB: case OP_LBU: case OP_LH: case OP_LHU:
+      case OP_LW: case OP_LWL: case OP_LWR:
+	return 1;
+      default:
+	return 0;
+    }
+}
+
+/* where a branch or jump at "pc" goes, if it is taken; -1 for JR, JALR */
+int Target(Instruction *instr, int pc)
+{
+    switch (instr->opCode) {
+      case OP_J: case OP_JAL:
+	return ((pc + 8) & 0xf0000000) | IndexToAddr(instr->extra);
+      case OP_JR: case OP_JALR:
+	return -1;
+      default:
+	return pc + 4 + IndexToAddr(instr->extra);
+    }
+}
+
+/* the register an argument of the instruction's printed form refers to */
+int TypeToReg(RegType reg, Instruction *instr)
+{
+    switch (reg) {
+      case RS: return instr->rs;
+      case RT: return instr->rt;
+      case RD: return instr->rd;
+      case EXTRA: return instr->extra;
+      default: return -1;
+    }
+}
+
+/****************************************************************/
+
+/* Write out what an instruction the block does itself computes, and
+ * return 1; or return 0 if the simulator has to run it.  Loads and
+ * stores, and instructions that can trap, are left to the simulator,
+ * as are the rest of those the block engine leaves to it.
+ */
+int
+Compile(Instruction *instr, int pc)
+{
+    int rs = instr->rs, rt = instr->rt, rd = instr->rd;
+    int extra = instr->extra;
+    int target = Target(instr, pc);
+
+    switch (instr->opCode) {
+      case OP_ADDU:
+	if (rd != 0)
+	    fprintf(out, "    r[%d] = U(r[%d]) + U(r[%d]);\n", rd, rs, rt);
+	return 1;
+      case OP_ADDIU:
+	if (rt != 0)
+	    fprintf(out, "    r[%d] = U(r[%d]) + %uU;\n", rt, rs, extra);
+	return 1;
+      case OP_SUBU:
+	if (rd != 0)
+	    fprintf(out, "    r[%d] = U(r[%d]) - U(r[%d]);\n", rd, rs, rt);
+	return 1;
+      case OP_AND:
+	if (rd != 0)
+	    fprintf(out, "    r[%d] = r[%d] & r[%d];\n", rd, rs, rt);
+	return 1;
+      case OP_ANDI:
+	if (rt != 0)
+	    fprintf(out, "    r[%d] = r[%d] & %d;\n", rt, rs, extra & 0xffff);
+	return 1;
+      case OP_OR:
+	if (rd != 0)
+	    fprintf(out, "    r[%d] = r[%d] | r[%d];\n", rd, rs, rt);
+	return 1;
+      case OP_ORI:
+	if (rt != 0)
+	    fprintf(out, "    r[%d] = r[%d] | %d;\n", rt, rs, extra & 0xffff);
+	return 1;
+      case OP_XOR:
+	if (rd != 0)
+	    fprintf(out, "    r[%d] = r[%d] ^ r[%d];\n", rd, rs, rt);
+	return 1;
+      case OP_XORI:
+	if (rt != 0)
+	    fprintf(out, "    r[%d] = r[%d] ^ %d;\n", rt, rs, extra & 0xffff);
+	return 1;
+      case OP_NOR:
+	if (rd != 0)
+	    fprintf(out, "    r[%d] = ~(r[%d] | r[%d]);\n", rd, rs, rt);
+	return 1;
+      case OP_SLT:
+	if (rd != 0)
+	    fprintf(out, "    r[%d] = r[%d] < r[%d];\n", rd, rs, rt);
+	return 1;
+      case OP_SLTI:
+	if (rt != 0)
+	    fprintf(out, "    r[%d] = r[%d] < %d;\n", rt, rs, extra);
+	return 1;
+      case OP_SLTU:
+	if (rd != 0)
+	    fprintf(out, "    r[%d] = U(r[%d]) < U(r[%d]);\n", rd, rs, rt);
+	return 1;
+      case OP_SLTIU:
+	if (rt != 0)
+	    fprintf(out, "    r[%d] = U(r[%d]) < %uU;\n", rt, rs, extra);
+	return 1;
+
+      /* the simulator does SRL and SRLV through a signed int, so they
+       * come out the same as SRA and SRAV; keep it that way */
+      case OP_SLL:
+	if (rd != 0)
+	    fprintf(out, "    r[%d] = U(r[%d]) << %d;\n", rd, rt, extra);
+	return 1;
+      case OP_SRA:
+      case OP_SRL:
+	if (rd != 0)
+	    fprintf(out, "    r[%d] = r[%d] >> %d;\n", rd, rt, extra);
+	return 1;
+      case OP_SLLV:
+	if (rd != 0)
+	    fprintf(out, "    r[%d] = U(r[%d]) << (r[%d] & 0x1f);\n",
+		    rd, rt, rs);
+	return 1;
+      case OP_SRAV:
+      case OP_SRLV:
+	if (rd != 0)
+	    fprintf(out, "    r[%d] = r[%d] >> (r[%d] & 0x1f);\n", rd, rt, rs);
+	return 1;
+
+      case OP_LUI:
+	if (rt != 0)
+	    fprintf(out, "    r[%d] = %uU;\n", rt, (unsigned int)extra << 16);
+	return 1;
+      case OP_MFHI:
+	if (rd != 0)
+	    fprintf(out, "    r[%d] = r[NativeHiReg];\n", rd);
+	return 1;
+      case OP_MFLO:
+	if (rd != 0)
+	    fprintf(out, "    r[%d] = r[NativeLoReg];\n", rd);
+	return 1;
+      case OP_MTHI:
+	fprintf(out, "    r[NativeHiReg] = r[%d];\n", rs);
+	return 1;
+      case OP_MTLO:
+	fprintf(out, "    r[NativeLoReg] = r[%d];\n", rs);
+	return 1;
+
+      /* Branches just work out where to go.  A link register is
+       * written before the branch reads its operand, as in the
+       * simulator, even if it is r0. */
+      case OP_BEQ:
+	fprintf(out, "    c->target = r[%d] == r[%d] ? 0x%x : 0x%x;\n",
+		rs, rt, target, pc + 8);
+	return 1;
+      case OP_BNE:
+	fprintf(out, "    c->target = r[%d] != r[%d] ? 0x%x : 0x%x;\n",
+		rs, rt, target, pc + 8);
+	return 1;
+      case OP_BLEZ:
+	fprintf(out, "    c->target = r[%d] <= 0 ? 0x%x : 0x%x;\n",
+		rs, target, pc + 8);
+	return 1;
+      case OP_BGTZ:
+	fprintf(out, "    c->target = r[%d] > 0 ? 0x%x : 0x%x;\n",
+		rs, target, pc + 8);
+	return 1;
+      case OP_BLTZAL:
+	fprintf(out, "    r[31] = 0x%x;\n", pc + 8);
+      case OP_BLTZ:
+	fprintf(out, "    c->target = r[%d] < 0 ? 0x%x : 0x%x;\n",
+		rs, target, pc + 8);
+	return 1;
+      case OP_BGEZAL:
+	fprintf(out, "    r[31] = 0x%x;\n", pc + 8);
+      case OP_BGEZ:
+	fprintf(out, "    c->target = r[%d] >= 0 ? 0x%x : 0x%x;\n",
+		rs, target, pc + 8);
+	return 1;
+      case OP_JAL:
+	fprintf(out, "    r[31] = 0x%x;\n", pc + 8);
+      case OP_J:
+	fprintf(out, "    c->target = 0x%x;\n", target);
+	return 1;
+      case OP_JALR:
+	fprintf(out, "    r[%d] = 0x%x;\n", rd, pc + 8);
+	fprintf(out, "    c->target = r[%d];\n", rs);
+	if (rd == 0)
+	    fprintf(out, "    r[0] = 0;\n");
+	return 1;
+      case OP_JR:
+	fprintf(out, "    c->target = r[%d];\n", rs);
+	return 1;
+
+      default:
+	return 0;
+    }
+}
+
+/* Write out the block of "n" instructions starting at "start", which
+ * looked at "numWords" words.
+ */
+void
+WriteBlock(Instruction *code, int codeAddr, int start, int n, int numWords)
+{
+    int pending = PendingUnknown;
+    int i, pc;
+    Instruction *instr;
+    struct OpString *str;
+    char buf[80];
+
+    fprintf(out, "\nstatic const unsigned int w%x[] = {", codeAddr + start * 4);
+    for (i = 0; i < numWords; i++)
+	fprintf(out, "%s0x%x",
+		(i == 0) ? "\n    " : (i % 6 == 0) ? ",\n    " : ", ",
+		code[start + i].value);
+    fprintf(out, "\n};\n\n");
+
+    fprintf(out, "static int\nb%x(NativeContext *c, int *r)\n{",
+	    codeAddr + start * 4);
+    for (i = 0; i < n; i++) {
+	instr = &code[start + i];
+	pc = codeAddr + (start + i) * 4;
+	str = &opStrings[(int) instr->opCode];
+	sprintf(buf, str->format, TypeToReg(str->args[0], instr),
+		TypeToReg(str->args[1], instr), TypeToReg(str->args[2], instr));
+	fprintf(out, "\n    /* 0x%x: %s */\n", pc, buf);
+
+	if (!Compile(instr, pc)) {	/* the simulator does the delayed
+					 * load, and sets up the next one */
+	    fprintf(out, "    STEP(%d);\n", i);
+	    pending = IsLoad(instr) ? instr->rt : PendingNone;
+	    continue;
+	}
+	if (pending == PendingUnknown)
+	    fprintf(out, "    FINISH_LOAD();\n");
+	else if (pending == 0)
+	    fprintf(out, "    CLEAR_LOAD();\n");
+	else if (pending != PendingNone)
+	    fprintf(out, "    FINISH_LOAD_TO(%d);\n", pending);
+	pending = PendingNone;
+    }
+    fprintf(out, "    return 1;\n}\n");
+}
+
+int
+main (int argc, char **argv)
+{
+    int fdIn, numWords, pageSize = 128;
+    NoffHeader noffH;
+    unsigned int *words;
+    Instruction *code;
+    char *isEntry;
+    int codeAddr, numBlocks, i, j, n, target, blockWords, branch;
+    int *blockInstrs, *blockSize, *blockBranch;
+
+    if (argc > 2 && !strcmp(argv[1], "-ps")) {
+	pageSize = atoi(argv[2]);
+	argc -= 2;
+	argv += 2;
+    }
+    if (argc < 3 || pageSize < 4 || (pageSize & (pageSize - 1)) != 0) {
+	fprintf(stderr, "Usage: %s [-ps <pageSize>] <noffFileName> <cFileName>\n",
+		argv[0]);
+	exit(1);
+    }
+
+/* open the NOFF file (input) */
+    fdIn = open(argv[1], O_RDONLY, 0);
+    if (fdIn == -1) {
+	perror(argv[1]);
+	exit(1);
+    }
+
+/* Read in the header and check the magic number. */
+    Read(fdIn, (char *) &noffH, sizeof(noffH));
+    SwapHeader(&noffH);
+    if (noffH.noffMagic != NOFFMAGIC) {
+	fprintf(stderr, "File is not a NOFF file\n");
+	exit(1);
+    }
+
+/* Read in and decode the code segment */
+    codeAddr = noffH.code.virtualAddr;
+    numWords = noffH.code.size / 4;
+    words = (unsigned int *) malloc(numWords * 4 + 4);
+    code = (Instruction *) calloc(numWords + 1, sizeof(Instruction));
+    lseek(fdIn, noffH.code.inFileAddr, 0);
+    Read(fdIn, (char *) words, numWords * 4);
+    close(fdIn);
+    for (i = 0; i < numWords; i++)
+	Decode(WordToHost(words[i]), &code[i]);
+
+/* Find where blocks may start */
+    isEntry = (char *) calloc(numWords + 2, 1);
+    isEntry[0] = 1;
+    for (i = 0; i < numWords; i++) {
+	if (code[i].opCode == OP_SYSCALL)
+	    isEntry[i + 1] = 1;
+	if (!IsBranch(&code[i]))
+	    continue;
+	isEntry[i + 2 <= numWords ? i + 2 : numWords] = 1;
+	target = Target(&code[i], codeAddr + i * 4);
+	if (target >= codeAddr && target < codeAddr + numWords * 4 &&
+	    (target & 3) == 0)
+	    isEntry[(target - codeAddr) / 4] = 1;
+    }
+
+/* Cut up each block as Machine::TranslateBlock does */
+    blockInstrs = (int *) calloc(numWords, sizeof(int));
+    blockSize = (int *) calloc(numWords, sizeof(int));
+    blockBranch = (int *) calloc(numWords, sizeof(int));
+    for (i = 0; i < numWords; i++) {
+	int inPage = (pageSize - (codeAddr + i * 4) % pageSize) / 4;
+
+	if (!isEntry[i])
+	    continue;
+	n = 0;
+	blockWords = 0;
+	branch = 0;
+	for (j = 0; j < inPage; j++) {
+	    if (i + j >= numWords) {	/* runs off the end of the code */
+		n = 0;
+		break;
+	    }
+	    blockWords = j + 1;
+	    if (!IsBranch(&code[i + j])) {
+		n = j + 1;
+		continue;
+	    }
+	    if (j + 1 < inPage) {
+		if (i + j + 1 >= numWords) {
+		    n = 0;
+		    break;
+		}
+		blockWords = j + 2;
+		if (!IsBranch(&code[i + j + 1])) {
+		    n = j + 2;
+		    branch = 1;
+		}
+	    }
+	    break;
+	}
+	blockInstrs[i] = n;
+	blockSize[i] = blockWords;
+	blockBranch[i] = branch;
+    }
+
+/* Write out the blocks, and then the table of them */
+    out = fopen(argv[2], "w");
+    if (out == NULL) {
+	perror(argv[2]);
+	exit(1);
+    }
+    fprintf(out, "/* %s -- the code of %s, compiled by noff2c.\n", argv[2], argv[1]);
+    fprintf(out, " * Build it into a shared library, and load it with\n");
+    fprintf(out, " * \"nachos -native\" (see native.h).\n */\n\n");
+    fprintf(out, "#include \"native.h\"\n\n");
+    fprintf(out, "#define U(x) ((unsigned int)(x))\n");
+    fprintf(out, "#define STEP(i) if (!c->step(c, (i))) return 0\n");
+    fprintf(out, "#define FINISH_LOAD() { \\\n"
+	    "    r[r[NativeLoadReg]] = r[NativeLoadValueReg]; \\\n"
+	    "    r[NativeLoadReg] = r[NativeLoadValueReg] = r[0] = 0; }\n");
+    fprintf(out, "#define FINISH_LOAD_TO(reg) { \\\n"
+	    "    r[reg] = r[NativeLoadValueReg]; \\\n"
+	    "    r[NativeLoadReg] = r[NativeLoadValueReg] = 0; }\n");
+    fprintf(out, "#define CLEAR_LOAD() { \\\n"
+	    "    r[NativeLoadReg] = r[NativeLoadValueReg] = 0; }\n");
+
+    numBlocks = 0;
+    for (i = 0; i < numWords; i++)
+	if (blockInstrs[i] > 0) {
+	    WriteBlock(code, codeAddr, i, blockInstrs[i], blockSize[i]);
+	    numBlocks++;
+	}
+
+    fprintf(out, "\nstatic const NativeBlock blocks[] = {\n");
+    for (i = 0; i < numWords; i++)
+	if (blockInstrs[i] > 0)
+	    fprintf(out, "    { 0x%x, %d, %d, %d, w%x, b%x },\n",
+		    codeAddr + i * 4, blockInstrs[i], blockSize[i],
+		    blockBranch[i], codeAddr + i * 4, codeAddr + i * 4);
+    if (numBlocks == 0)
+	fprintf(out, "    { -1, 0, 0, 0, 0, 0 }\n");
+    fprintf(out, "};\n\n");
+    /* the name is NativeModuleName, in native.h */
+    fprintf(out, "const NativeModule nachosNativeModule = {\n");
+    fprintf(out, "    NativeVersion, %d, %d, blocks\n};\n", pageSize, numBlocks);
+    fclose(out);
+    printf("%d blocks, from %d instructions\n", numBlocks, numWords);
+    exit(0);
+}